@@ -6,6 +6,12 @@
 // <<-- Creer-Merge: includes -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
 // You can add #includes here for your AI.
 #include "game_logic.h" 
+#include "bitbase.h"
+#include "logger.h"
+#include "memory_accounting.h"
+
+const int MAX_SEARCH_DEPTH = 32;      //Deepest iteration make_move will search to
+const double WARM_UP_SECONDS = 0.1;   //Quiet search run by start so the first move starts with warm caches
 // <<-- /Creer-Merge: includes -->>
 
 namespace cpp_client
@@ -34,7 +40,20 @@ void AI::start()
 {
     // <<-- Creer-Merge: start -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
     // This is a good place to initialize any variables
-    cout << "I am Player " << player->color << endl;
+    log_printf(LOG_INFO, "I am Player %s", player->color.c_str());
+
+    //The tables were allocated and their pages touched when the AI was made. Searching the starting
+    //position for a moment brings the code and tables into the caches, and what it learns is kept for the first move
+    chrono::steady_clock::time_point initStart = chrono::steady_clock::now();
+    engine.search.options.printIterations = true;
+    gameState warmState;
+    warmState.populate_board(game->fen);
+    long warmNodes = engine.search.warm_up(warmState, WARM_UP_SECONDS);
+    double initSeconds = chrono::duration<double>(chrono::steady_clock::now() - initStart).count();
+    log_printf(LOG_INFO, "Engine ready in %.3fs (%zuMB transposition table%s, %zuKB bitbases, warm-up searched %ld nodes)",
+               initSeconds, memory_charged(MEMORY_TRANSPOSITION_TABLE) / (1024 * 1024), engine.search.transpositionTable.huge_pages() ? " on huge pages" : "",
+               bitbase_bytes() / 1024, warmNodes);
+    log_memory_report("start", engine.plan.memoryMB);
     // <<-- /Creer-Merge: start -->>
 }
 
@@ -57,6 +76,9 @@ void AI::ended(bool won, const std::string& reason)
 {
     //<<-- Creer-Merge: ended -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
     // You can do any cleanup of your AI here.  The program ends when this function returns.
+    log_memory_report("game end", engine.plan.memoryMB);
+    //Write out whatever is still waiting in the log before the program ends
+    log_flush();
     //<<-- /Creer-Merge: ended -->>
 }
 
@@ -68,40 +90,27 @@ std::string AI::make_move()
 {
     // <<-- Creer-Merge: makeMove -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
 
-    //Create an instance of the game
-    gameState startState;
-
-    //Determine if this is the first turn
-    if(game->history.size() == 0 ){
-      startState.isFirstMove = true;
-    } else {
-      startState.isFirstMove = false;
-    }
-
-    //Populate the gamestate datastructure using the FEN string
-    string fen = game->fen;
-    startState.populate_board(fen);
+    //Give the engine the game from the starting position so it knows which positions have already happened
+    engine.set_game(game->fen, game->history);
 
     //Print the board to the user before the move is made
-    startState.print_board();
-
-    //Generate all valid moves that can be made
-    vector<string> moves;
-    startState.get_valid_moves(moves, player->color, startState.gameBoard);
-
-    srand(time(NULL));
-    //Randomly choose one, then find moves that originate from the same piece
-    int randIndex = (rand() % moves.size());
-    string moveSubStr =  moves[randIndex].substr(0,2);
-    for(int k = 0; k < moves.size(); k++){
-      if(moves[k].substr(0,2) == moveSubStr){
-        cout << moves[k] << " ";
-      }
-    }
-    cout << endl;
+    engine.position.print_board();
+
+    //Search for the best move, one ply deeper at a time until the time manager says to stop.
+    //The framework gives the time left in nanoseconds
+    SearchLimits limits;
+    limits.clockSeconds = player->time_remaining / 1e9;
+    limits.depth = MAX_SEARCH_DEPTH;
+    string best = engine.start(limits).get();
+    Search & search = engine.search;
+    TimeManager & timeManager = engine.timeManager;
+    log_printf(LOG_INFO, "Best move: %s (%ld nodes in %.3fs of %.3fs soft, %.3fs hard, eval cache hits %ld/%ld, "
+               "transposition table hits %ld/%ld)", best.c_str(), search.nodes, timeManager.elapsed(),
+               timeManager.softLimit, timeManager.hardLimit, search.evalCache.hits, search.evalCache.probes,
+               search.transpositionTable.hits, search.transpositionTable.probes);
     // <<-- /Creer-Merge: makeMove -->>
     //return std::string{};
-    return moves[randIndex];
+    return best;
 }
 
 //<<-- Creer-Merge: methods -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
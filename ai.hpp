@@ -11,6 +11,9 @@
 
 // <<-- Creer-Merge: includes -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
 // You can add additional #includes here
+#include "engine.h"
+
+const int AI_MEMORY_MB = DEFAULT_ENGINE_MEMORY_MB;  //Budget for every table of the engine together, see plan_memory
 // <<-- /Creer-Merge: includes -->>
 
 namespace cpp_client
@@ -37,6 +40,7 @@ public:
 
     //<<-- Creer-Merge: class variables -->> - Code you add between this comment and the end comment will be preserved between Creer re-runs.
     // You can add additional class variables here.
+    Engine engine{AI_MEMORY_MB};  //Position, search and caches, kept between moves
     //<<-- /Creer-Merge: class variables -->>
 
     /// <summary>
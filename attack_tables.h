@@ -0,0 +1,176 @@
+#ifndef ATTACK_TABLES_H
+#define ATTACK_TABLES_H
+#include <cstdint>
+
+//Squares used by the tables are numbered square = x*8 + y, where x is the gameBoard row
+//(0 is the 8th rank) and y is the gameBoard column (0 is the a file), matching gameBoard[x][y].
+//A set of squares is stored as a 64 bit mask with bit (x*8 + y) set for each square in it.
+//Every table below is generated by the compiler, so there is no startup cost to use them.
+
+enum { WHITE = 0, BLACK = 1 };
+
+//Table of one square set per square
+struct SquareTable {
+  uint64_t sq[64];
+};
+
+//Table of one square set per pair of squares
+struct SquarePairTable {
+  uint64_t sq[64][64];
+};
+
+//Table of one small number per pair of squares
+struct DistanceTable {
+  int8_t sq[64][64];
+};
+
+//Table of one square set per color per square
+struct ColorSquareTable {
+  uint64_t sq[2][64];
+};
+
+//PRE : None
+//POST: returns TRUE if (x,y) is on the board
+//DESC: Bounds check used while the tables are generated
+constexpr bool on_board(int x, int y){
+  return x >= 0 && x < 8 && y >= 0 && y < 8;
+}
+
+//PRE : (x,y) must be on the board
+//POST: returns the mask with only square (x,y) set
+//DESC: Converts a board position into a single square mask
+constexpr uint64_t square_bit(int x, int y){
+  return uint64_t(1) << (x*8 + y);
+}
+
+constexpr int abs_diff(int a, int b){
+  return a > b ? a - b : b - a;
+}
+
+constexpr SquareTable make_leaper_table(const int (&offsets)[8][2]){
+  SquareTable table = {};
+  for(int s = 0; s < 64; s++){
+    for(int k = 0; k < 8; k++){
+      int x = s/8 + offsets[k][0];
+      int y = s%8 + offsets[k][1];
+      if(on_board(x, y)){
+        table.sq[s] |= square_bit(x, y);
+      }
+    }
+  }
+  return table;
+}
+
+constexpr int KNIGHT_OFFSETS[8][2] = {{2,1},{2,-1},{-2,1},{-2,-1},{1,2},{-1,2},{1,-2},{-1,-2}};
+constexpr int KING_OFFSETS[8][2] = {{1,1},{1,0},{1,-1},{0,1},{0,-1},{-1,1},{-1,0},{-1,-1}};
+
+constexpr ColorSquareTable make_pawn_table(){
+  ColorSquareTable table = {};
+  for(int s = 0; s < 64; s++){
+    int x = s/8;
+    int y = s%8;
+    //White pawns move up the board (x-1), black pawns move down (x+1)
+    for(int dy = -1; dy <= 1; dy += 2){
+      if(on_board(x-1, y+dy)) table.sq[WHITE][s] |= square_bit(x-1, y+dy);
+      if(on_board(x+1, y+dy)) table.sq[BLACK][s] |= square_bit(x+1, y+dy);
+    }
+  }
+  return table;
+}
+
+//Returns the step (-1, 0 or 1) from a towards b
+constexpr int step_toward(int a, int b){
+  return a < b ? 1 : (a > b ? -1 : 0);
+}
+
+//TRUE if a and b share a rank, file or diagonal
+constexpr bool aligned(int a, int b){
+  return a != b &&
+         (a/8 == b/8 || a%8 == b%8 || abs_diff(a/8, b/8) == abs_diff(a%8, b%8));
+}
+
+constexpr SquarePairTable make_between_table(){
+  SquarePairTable table = {};
+  for(int a = 0; a < 64; a++){
+    for(int b = 0; b < 64; b++){
+      if(aligned(a, b)){
+        int dx = step_toward(a/8, b/8);
+        int dy = step_toward(a%8, b%8);
+        //Walk from a to b, not including either end
+        for(int x = a/8 + dx, y = a%8 + dy; x*8 + y != b; x += dx, y += dy){
+          table.sq[a][b] |= square_bit(x, y);
+        }
+      }
+    }
+  }
+  return table;
+}
+
+constexpr SquarePairTable make_line_table(){
+  SquarePairTable table = {};
+  for(int a = 0; a < 64; a++){
+    for(int b = 0; b < 64; b++){
+      if(aligned(a, b)){
+        int dx = step_toward(a/8, b/8);
+        int dy = step_toward(a%8, b%8);
+        table.sq[a][b] |= square_bit(a/8, a%8);
+        //Walk outward from a in both directions to the edge of the board
+        for(int x = a/8 + dx, y = a%8 + dy; on_board(x, y); x += dx, y += dy){
+          table.sq[a][b] |= square_bit(x, y);
+        }
+        for(int x = a/8 - dx, y = a%8 - dy; on_board(x, y); x -= dx, y -= dy){
+          table.sq[a][b] |= square_bit(x, y);
+        }
+      }
+    }
+  }
+  return table;
+}
+
+constexpr DistanceTable make_distance_table(){
+  DistanceTable table = {};
+  for(int a = 0; a < 64; a++){
+    for(int b = 0; b < 64; b++){
+      int dx = abs_diff(a/8, b/8);
+      int dy = abs_diff(a%8, b%8);
+      table.sq[a][b] = int8_t(dx > dy ? dx : dy);
+    }
+  }
+  return table;
+}
+
+//Squares a knight on the square attacks
+constexpr SquareTable KNIGHT_ATTACKS = make_leaper_table(KNIGHT_OFFSETS);
+
+//Squares a king on the square attacks
+constexpr SquareTable KING_ATTACKS = make_leaper_table(KING_OFFSETS);
+
+//Squares a pawn of the color (WHITE or BLACK) on the square attacks
+constexpr ColorSquareTable PAWN_ATTACKS = make_pawn_table();
+
+//Squares strictly between two squares on a shared rank, file or diagonal. Empty if not aligned
+constexpr SquarePairTable BETWEEN = make_between_table();
+
+//Every square of the full rank, file or diagonal through two squares. Empty if not aligned
+constexpr SquarePairTable LINE = make_line_table();
+
+//Number of king steps between two squares
+constexpr DistanceTable DISTANCE = make_distance_table();
+
+//PRE : b must not be 0
+//POST: returns the lowest square in the set
+//DESC: Finds the index of the least significant set bit
+inline int lsb(uint64_t b){
+  return __builtin_ctzll(b);
+}
+
+//PRE : b must not be 0
+//POST: the lowest square is removed from b and returned
+//DESC: Used to loop over every square in a set
+inline int pop_lsb(uint64_t & b){
+  int s = __builtin_ctzll(b);
+  b &= b - 1;
+  return s;
+}
+
+#endif
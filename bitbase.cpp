@@ -0,0 +1,529 @@
+#include "bitbase.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "evaluate.h"
+#include "memory_accounting.h"
+
+//The tables are built with the winning side as white, pawns moving toward row 0. The strong side's pieces are
+//sq[0] its king, sq[1] the lone king, then the strong side's other pieces
+enum Ending { KPK, KQK, KRK, KBNK, ENDING_COUNT };
+static const char ENDING_PIECES[ENDING_COUNT][3] = {"P", "Q", "R", "BN"};
+
+enum { STRONG_TO_MOVE = 0, WEAK_TO_MOVE = 1 };
+
+//States of a position while a table is built
+enum { UNKNOWN = 0, ILLEGAL, DRAW, WIN_PENDING, WIN };
+
+struct EndgamePosition {
+  int side;      //STRONG_TO_MOVE or WEAK_TO_MOVE
+  int sq[4];
+};
+
+//The ten squares x <= y <= 3, where the strong king is put to store KBNK
+static const int TRIANGLE[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+static vector<uint64_t> tables[ENDING_COUNT];
+static atomic<bool> ready(false);
+static once_flag buildOnce;
+
+static uint64_t bit(int square){
+  return uint64_t(1) << square;
+}
+
+static int flip_file(int square){
+  return square - square % 8 + 7 - square % 8;
+}
+
+static int flip_row(int square){
+  return (7 - square / 8) * 8 + square % 8;
+}
+
+static int transpose(int square){
+  return (square % 8) * 8 + square / 8;
+}
+
+//PRE : None
+//POST: returns the squares a slider on square reaches, up to and including the first occupied square each way
+static uint64_t slider_attacks(int square, uint64_t occupied, bool diagonals, bool straights){
+  uint64_t attacks = 0;
+  for(int dx = -1; dx <= 1; dx++){
+    for(int dy = -1; dy <= 1; dy++){
+      if(dx == 0 && dy == 0) continue;
+      bool diagonal = (dx != 0 && dy != 0);
+      if((diagonal && !diagonals) || (!diagonal && !straights)) continue;
+      for(int x = square/8 + dx, y = square%8 + dy; on_board(x, y); x += dx, y += dy){
+        attacks |= square_bit(x, y);
+        if(occupied & square_bit(x, y)) break;
+      }
+    }
+  }
+  return attacks;
+}
+
+//PRE : piece must be one of "KPQRBN" of the strong side
+//POST: returns the squares piece on square attacks
+static uint64_t piece_attacks(char piece, int square, uint64_t occupied){
+  switch(piece){
+    case 'K': return KING_ATTACKS.sq[square];
+    case 'P': return PAWN_ATTACKS.sq[WHITE][square];
+    case 'N': return KNIGHT_ATTACKS.sq[square];
+    case 'B': return slider_attacks(square, occupied, true, false);
+    case 'R': return slider_attacks(square, occupied, false, true);
+    default : return slider_attacks(square, occupied, true, true);
+  }
+}
+
+//PRE : piece must be one of "KPQRBN" of the strong side, from and to must be different squares
+//POST: returns TRUE if piece on from attacks to
+//DESC: Sliders only check the squares between, which is much faster than building the whole attack set
+static bool attacks_square(char piece, int from, int to, uint64_t occupied){
+  if(piece == 'K' || piece == 'P' || piece == 'N') return (piece_attacks(piece, from, occupied) >> to) & 1;
+  bool straight = (from / 8 == to / 8 || from % 8 == to % 8);
+  bool diagonal = abs(from / 8 - to / 8) == abs(from % 8 - to % 8);
+  if(!(piece == 'B' ? diagonal : (piece == 'R' ? straight : straight || diagonal))) return false;
+  return (BETWEEN.sq[from][to] & occupied) == 0;
+}
+
+//Builds one table. Positions are stored with the pawn, or the strong king if there is no pawn, flipped onto the
+//a-d files (and rows 0-3 without a pawn). No position is its own flip, so each one has exactly one entry and every
+//move from an entry is found exactly once when working backward from the entry it leads to
+class BitbaseBuilder{
+  public:
+    //PRE : ending must be built after the endings it promotes into
+    //POST: the table for ending is built
+    BitbaseBuilder(Ending ending){
+      this->ending = ending;
+      pieceCount = 2 + int(strlen(ENDING_PIECES[ending]));
+      pieces[0] = 'K';
+      pieces[1] = 'K';
+      for(int k = 2; k < pieceCount; k++) pieces[k] = ENDING_PIECES[ending][k-2];
+      pawn = (ending == KPK);
+      keyPiece = (pawn ? 2 : 0);
+      keyCount = (pawn ? 32 : 16);
+      size = 2 * keyCount;
+      for(int k = 1; k < pieceCount; k++) size *= 64;
+      state.assign(size, UNKNOWN);
+      counter.assign(size, 0);
+      memory_charge(MEMORY_BITBASES, 2 * (long long)size);
+
+      for(uint32_t i = 0; i < size; i++){
+        classify(i);
+      }
+      //Wins spread backward one pass at a time until a pass finds nothing new
+      bool changed = true;
+      while(changed){
+        changed = false;
+        for(uint32_t i = 0; i < size; i++){
+          if(state[i] != WIN_PENDING) continue;
+          state[i] = WIN;
+          changed = true;
+          spread_win(i);
+        }
+      }
+      pack();
+    }
+
+    ~BitbaseBuilder(){
+      memory_charge(MEMORY_BITBASES, -2 * (long long)size);
+    }
+
+  private:
+    Ending ending;
+    int pieceCount;
+    char pieces[4];
+    bool pawn;
+    int keyPiece;           //Piece whose square picks the flip
+    int keyCount;           //Squares the key piece can be stored on
+    uint32_t size;
+    vector<uint8_t> state;
+    vector<uint8_t> counter;  //Moves of the lone king not yet known to lose
+
+    //PRE : None
+    //POST: position is flipped so its key piece is on the stored files and rows
+    void canonicalize(EndgamePosition & position){
+      if(position.sq[keyPiece] % 8 > 3){
+        for(int k = 0; k < pieceCount; k++) position.sq[k] = flip_file(position.sq[k]);
+      }
+      if(!pawn && position.sq[keyPiece] / 8 > 3){
+        for(int k = 0; k < pieceCount; k++) position.sq[k] = flip_row(position.sq[k]);
+      }
+    }
+
+    //PRE : position must be canonical
+    uint32_t index(const EndgamePosition & position){
+      int key = position.sq[keyPiece];
+      uint32_t i = position.side * keyCount + (key / 8) * 4 + key % 8;
+      for(int k = 0; k < pieceCount; k++){
+        if(k != keyPiece) i = i * 64 + position.sq[k];
+      }
+      return i;
+    }
+
+    EndgamePosition decode(uint32_t i){
+      EndgamePosition position;
+      for(int k = pieceCount - 1; k >= 0; k--){
+        if(k == keyPiece) continue;
+        position.sq[k] = i % 64;
+        i /= 64;
+      }
+      int key = i % keyCount;
+      position.sq[keyPiece] = (key / 4) * 8 + key % 4;
+      position.side = i / keyCount;
+      return position;
+    }
+
+    uint64_t occupancy(const EndgamePosition & position){
+      uint64_t occupied = 0;
+      for(int k = 0; k < pieceCount; k++) occupied |= bit(position.sq[k]);
+      return occupied;
+    }
+
+    //PRE : None
+    //POST: returns TRUE if a strong piece other than skip attacks square
+    bool attacked(const EndgamePosition & position, int square, uint64_t occupied, int skip){
+      for(int k = 0; k < pieceCount; k++){
+        if(k == 1 || k == skip) continue;
+        if(position.sq[k] != square && attacks_square(pieces[k], position.sq[k], square, occupied)) return true;
+      }
+      return false;
+    }
+
+    //PRE : None
+    //POST: returns TRUE if the position can happen in a game
+    bool legal(const EndgamePosition & position){
+      if(__builtin_popcountll(occupancy(position)) != pieceCount) return false;
+      if(DISTANCE.sq[position.sq[0]][position.sq[1]] <= 1) return false;
+      if(pawn && (position.sq[2] / 8 == 0 || position.sq[2] / 8 == 7)) return false;
+      //The lone king may not be left in check with the strong side to move
+      return position.side == WEAK_TO_MOVE || !attacked(position, position.sq[1], occupancy(position), -1);
+    }
+
+    //PRE : None
+    //POST: state of entry i is set from the position alone: illegal, mate, stalemate, a capture that draws,
+    //      a promotion that wins, or unknown with its count of lone king moves
+    void classify(uint32_t i){
+      EndgamePosition position = decode(i);
+      if(!legal(position)){
+        state[i] = ILLEGAL;
+        return;
+      }
+      uint64_t occupied = occupancy(position);
+      if(position.side == STRONG_TO_MOVE){
+        if(pawn && position.sq[2] / 8 == 1 && !(occupied & bit(position.sq[2] - 8)) && promotion_wins(position)){
+          state[i] = WIN_PENDING;
+        }
+        return;
+      }
+      //Lone king to move. Taking a piece leaves a king and at most a minor piece, which is a draw
+      int moves = 0;
+      uint64_t targets = KING_ATTACKS.sq[position.sq[1]] & ~KING_ATTACKS.sq[position.sq[0]] & ~bit(position.sq[0]);
+      while(targets){
+        int to = pop_lsb(targets);
+        int taken = -1;
+        for(int k = 2; k < pieceCount; k++){
+          if(position.sq[k] == to) taken = k;
+        }
+        if(attacked(position, to, occupied & ~bit(position.sq[1]), taken)) continue;
+        if(taken >= 0){
+          state[i] = DRAW;
+          return;
+        }
+        moves++;
+      }
+      if(moves == 0){
+        state[i] = attacked(position, position.sq[1], occupied, -1) ? WIN_PENDING : DRAW;
+        return;
+      }
+      counter[i] = uint8_t(moves);
+    }
+
+    //PRE : position must be KPK with the strong side to move and its pawn free to reach row 0
+    //POST: returns TRUE if promoting to a queen or a rook wins
+    bool promotion_wins(const EndgamePosition & position);
+
+    //PRE : entry i must have just become a win
+    //POST: every position with a move into entry i is updated
+    //DESC: A strong side move into a won position wins. A lone king move into one wins only once every
+    //      other move of the lone king is known to lose too
+    void spread_win(uint32_t i){
+      EndgamePosition position = decode(i);
+      uint64_t occupied = occupancy(position);
+      if(position.side == WEAK_TO_MOVE){
+        for(int k = 0; k < pieceCount; k++){
+          if(k == 1) continue;
+          int square = position.sq[k];
+          uint64_t origins;
+          if(pieces[k] == 'P'){
+            //Pawns only move forward, so they came from one row back, or two from their first row
+            origins = 0;
+            if(square / 8 + 1 <= 6 && !(occupied & bit(square + 8))){
+              origins |= bit(square + 8);
+              if(square / 8 == 4 && !(occupied & bit(square + 16))) origins |= bit(square + 16);
+            }
+          } else {
+            origins = piece_attacks(pieces[k], square, occupied) & ~occupied;
+            if(k == 0) origins &= ~KING_ATTACKS.sq[position.sq[1]];
+          }
+          while(origins){
+            EndgamePosition before = position;
+            before.sq[k] = pop_lsb(origins);
+            before.side = STRONG_TO_MOVE;
+            //Positions leaving the lone king in check were marked ILLEGAL by classify, so they stay untouched
+            canonicalize(before);
+            uint32_t j = index(before);
+            if(state[j] == UNKNOWN) state[j] = WIN_PENDING;
+          }
+        }
+      } else {
+        uint64_t origins = KING_ATTACKS.sq[position.sq[1]] & ~occupied & ~KING_ATTACKS.sq[position.sq[0]];
+        while(origins){
+          EndgamePosition before = position;
+          before.sq[1] = pop_lsb(origins);
+          before.side = WEAK_TO_MOVE;
+          canonicalize(before);
+          uint32_t j = index(before);
+          if(state[j] == UNKNOWN && --counter[j] == 0) state[j] = WIN_PENDING;
+        }
+      }
+    }
+
+    //PRE : every entry must be decided
+    //POST: tables[ending] holds one bit per stored position, set for a strong side win
+    //DESC: KBNK keeps only the lone king to move, with the strong king on the ten triangle squares, since it is
+    //      by far the largest. The strong side's moves are tried one ply deep when it is to move
+    void pack(){
+      vector<uint64_t> & table = tables[ending];
+      if(ending != KBNK){
+        table.assign((size + 63) / 64, 0);
+        for(uint32_t i = 0; i < size; i++){
+          if(state[i] == WIN) table[i / 64] |= bit(i % 64);
+        }
+        return;
+      }
+      uint32_t packedSize = 10 * 64 * 64 * 64;
+      table.assign(packedSize / 64, 0);
+      for(uint32_t p = 0; p < packedSize; p++){
+        EndgamePosition position;
+        position.side = WEAK_TO_MOVE;
+        position.sq[0] = TRIANGLE[p / (64 * 64 * 64)];
+        position.sq[1] = (p / (64 * 64)) % 64;
+        position.sq[2] = (p / 64) % 64;
+        position.sq[3] = p % 64;
+        if(state[index(position)] == WIN) table[p / 64] |= bit(p % 64);
+      }
+    }
+};
+
+//PRE : ending must be packed, position must be a legal position of it
+//POST: returns TRUE if the strong side wins
+static bool lookup(Ending ending, EndgamePosition position);
+
+bool BitbaseBuilder::promotion_wins(const EndgamePosition & position){
+  //The new piece is on row 0 and the lone king is to move
+  EndgamePosition promoted;
+  promoted.side = WEAK_TO_MOVE;
+  promoted.sq[0] = position.sq[0];
+  promoted.sq[1] = position.sq[1];
+  promoted.sq[2] = position.sq[2] - 8;
+  return lookup(KQK, promoted) || lookup(KRK, promoted);
+}
+
+static bool test_bit(Ending ending, uint32_t i){
+  return (tables[ending][i / 64] >> (i % 64)) & 1;
+}
+
+static bool lookup(Ending ending, EndgamePosition position){
+  int pieceCount = 2 + int(strlen(ENDING_PIECES[ending]));
+  bool pawn = (ending == KPK);
+  int key = (pawn ? 2 : 0);
+  if(position.sq[key] % 8 > 3){
+    for(int k = 0; k < pieceCount; k++) position.sq[k] = flip_file(position.sq[k]);
+  }
+  if(!pawn && position.sq[key] / 8 > 3){
+    for(int k = 0; k < pieceCount; k++) position.sq[k] = flip_row(position.sq[k]);
+  }
+
+  if(ending != KBNK){
+    int keyCount = (pawn ? 32 : 16);
+    uint32_t i = position.side * keyCount + (position.sq[key] / 8) * 4 + position.sq[key] % 8;
+    for(int k = 0; k < pieceCount; k++){
+      if(k != key) i = i * 64 + position.sq[k];
+    }
+    return test_bit(ending, i);
+  }
+
+  if(position.side == STRONG_TO_MOVE){
+    //Only the lone king to move is stored, so the strong side wins if one of its moves leads to a stored win
+    uint64_t occupied = 0;
+    for(int k = 0; k < 4; k++) occupied |= bit(position.sq[k]);
+    static const char PIECES[4] = {'K', 'K', 'B', 'N'};
+    for(int k = 0; k < 4; k++){
+      if(k == 1) continue;
+      uint64_t targets = piece_attacks(PIECES[k], position.sq[k], occupied) & ~occupied;
+      if(k == 0) targets &= ~KING_ATTACKS.sq[position.sq[1]];
+      while(targets){
+        EndgamePosition after = position;
+        after.sq[k] = pop_lsb(targets);
+        after.side = WEAK_TO_MOVE;
+        if(lookup(KBNK, after)) return true;
+      }
+    }
+    return false;
+  }
+  //Past the quadrant flips, a strong king below the diagonal is mirrored onto the triangle
+  if(position.sq[0] / 8 > position.sq[0] % 8){
+    for(int k = 0; k < 4; k++) position.sq[k] = transpose(position.sq[k]);
+  }
+  int triangle = int(find(TRIANGLE, TRIANGLE + 10, position.sq[0]) - TRIANGLE);
+  uint32_t i = ((triangle * 64 + position.sq[1]) * 64 + position.sq[2]) * 64 + position.sq[3];
+  return test_bit(KBNK, i);
+}
+
+void init_bitbases(){
+  call_once(buildOnce, [](){
+    //KBNK is as big as the other three together, so it is built on its own thread. KPK promotes into KQK and
+    //KRK, so those come first. Each builder's working arrays are freed once its table is packed
+    thread knightAndBishop([](){ BitbaseBuilder builder(KBNK); });
+    const Ending order[3] = {KQK, KRK, KPK};
+    for(int e = 0; e < 3; e++){
+      BitbaseBuilder builder(order[e]);
+    }
+    knightAndBishop.join();
+    ready.store(true, memory_order_release);
+    //Built once and kept for the life of the process, so never given back
+    memory_charge(MEMORY_BITBASES, bitbase_bytes());
+  });
+}
+
+size_t bitbase_bytes(){
+  if(!ready.load(memory_order_acquire)) return 0;
+  size_t bytes = 0;
+  for(int e = 0; e < ENDING_COUNT; e++){
+    bytes += tables[e].size() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+//PRE : state must be populated correctly
+//POST: returns TRUE if state is a bitbase ending, with its ending, position as the tables store it and the
+//      color of the strong side
+static bool find_ending(gameState & state, Ending & ending, EndgamePosition & position, bool & strongWhite){
+  if(!ready.load(memory_order_acquire)) return false;
+  //Every ending has three or four pieces, so almost every position is turned away by the counts alone
+  int count = 0;
+  for(int p = 0; p < 12; p++){
+    count += state.pieceCount[p];
+  }
+  if(count < 3 || count > 4) return false;
+  const char * pieces = "PNBRQKpnbrqk";
+  int squares[4];
+  char found[4];
+  count = 0;
+  for(int p = 0; p < 12; p++){
+    for(int n = 0; n < state.pieceCount[p]; n++){
+      squares[count] = state.pieceSquares[p][n];
+      found[count] = pieces[p];
+      count++;
+    }
+  }
+
+  //The strong side is the one with more than its king
+  int whitePieces = 0;
+  for(int k = 0; k < count; k++){
+    if(isupper(found[k])) whitePieces++;
+  }
+  strongWhite = (whitePieces > 1);
+  if((strongWhite ? count - whitePieces : whitePieces) != 1) return false;
+
+  int extra[2];
+  char extraType[2];
+  int extraCount = 0;
+  position.sq[0] = position.sq[1] = -1;
+  for(int k = 0; k < count; k++){
+    //Tables have the strong side as white, so a strong black side is flipped top to bottom
+    int square = (strongWhite ? squares[k] : flip_row(squares[k]));
+    bool strong = (isupper(found[k]) != 0) == strongWhite;
+    char type = char(toupper(found[k]));
+    if(type == 'K'){
+      position.sq[strong ? 0 : 1] = square;
+    } else {
+      extra[extraCount] = square;
+      extraType[extraCount] = type;
+      extraCount++;
+    }
+  }
+  if(position.sq[0] < 0 || position.sq[1] < 0) return false;
+  if(extraCount == 1){
+    if(extraType[0] == 'P') ending = KPK;
+    else if(extraType[0] == 'Q') ending = KQK;
+    else if(extraType[0] == 'R') ending = KRK;
+    else return false;
+    position.sq[2] = extra[0];
+  } else {
+    if(extraType[0] == 'B' && extraType[1] == 'N'){
+      position.sq[2] = extra[0];
+      position.sq[3] = extra[1];
+    } else if(extraType[0] == 'N' && extraType[1] == 'B'){
+      position.sq[2] = extra[1];
+      position.sq[3] = extra[0];
+    } else {
+      return false;
+    }
+    ending = KBNK;
+  }
+  bool whiteToMove = (state.active_color == "white");
+  position.side = (whiteToMove == strongWhite ? STRONG_TO_MOVE : WEAK_TO_MOVE);
+  return true;
+}
+
+BitbaseResult probe_bitbase(gameState & state){
+  Ending ending;
+  EndgamePosition position;
+  bool strongWhite;
+  if(!find_ending(state, ending, position, strongWhite)) return BITBASE_NONE;
+  if(!lookup(ending, position)) return BITBASE_DRAW;
+  return (position.side == STRONG_TO_MOVE ? BITBASE_WIN : BITBASE_LOSS);
+}
+
+bool bitbase_score(gameState & state, int & whiteScore){
+  Ending ending;
+  EndgamePosition position;
+  bool strongWhite;
+  if(!find_ending(state, ending, position, strongWhite)) return false;
+  if(!lookup(ending, position)){
+    whiteScore = 0;
+    return true;
+  }
+  int strongKing = position.sq[0];
+  int weakKing = position.sq[1];
+  int score = KNOWN_WIN_SCORE;
+  int progress = 0;
+  if(ending == KPK){
+    score += piece_value('P');
+    progress = 20 * (6 - position.sq[2] / 8);
+  } else {
+    for(int k = 0; ENDING_PIECES[ending][k] != '\0'; k++){
+      score += piece_value(ENDING_PIECES[ending][k]);
+    }
+    int x = weakKing / 8;
+    int y = weakKing % 8;
+    if(ending == KBNK){
+      //Mate is only possible in a corner the bishop's color
+      bool darkBishop = ((position.sq[2] / 8 + position.sq[2] % 8) % 2 == 1);
+      int corner = darkBishop ? min(DISTANCE.sq[weakKing][7], DISTANCE.sq[weakKing][56])
+                              : min(DISTANCE.sq[weakKing][0], DISTANCE.sq[weakKing][63]);
+      progress = 20 * (7 - corner);
+    } else {
+      int fromCenter = max(x < 4 ? 3 - x : x - 4, y < 4 ? 3 - y : y - 4);
+      progress = 20 * fromCenter;
+    }
+    progress += 10 * (7 - DISTANCE.sq[strongKing][weakKing]);
+  }
+  score += progress;
+  whiteScore = (strongWhite ? score : -score);
+  return true;
+}
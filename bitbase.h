@@ -0,0 +1,42 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+#include "game_logic.h"
+
+//Win/draw tables for a few endings of a king and one or two pieces against a bare king: KPK, KQK, KRK and KBNK.
+//Each is built by retrograde analysis the first time init_bitbases runs: mates are found first and wins are
+//worked backward from them, so every position left over is a draw. One bit is kept per position, about 400 KB
+//for all four, so the search and evaluation know the exact result of these endings instead of searching them.
+
+const int KNOWN_WIN_SCORE = 10000;  //Added to the evaluation of a won bitbase ending, far above any normal score
+
+enum BitbaseResult {
+  BITBASE_NONE,   //Not one of the endings in the bitbases
+  BITBASE_DRAW,
+  BITBASE_WIN,    //The color to move wins
+  BITBASE_LOSS    //The color to move loses
+};
+
+//PRE : None
+//POST: the bitbases are built
+//DESC: Only the first call does the work, later ones and calls from other threads wait for it to finish.
+//      The Search constructor calls it, so the first Search made waits about 2 seconds at -O2. Building
+//      uses about 17 MB of working arrays, mostly for KBNK, charged to MEMORY_BITBASES until they are freed
+void init_bitbases();
+
+//PRE : None
+//POST: returns the bytes used by the bitbases, 0 before init_bitbases
+size_t bitbase_bytes();
+
+//PRE : state must be populated correctly
+//POST: returns the result of state for the color to move, or BITBASE_NONE if it is not a bitbase ending
+//DESC: Cheap to call on any position, it is turned away by the piece counts unless there are three or four pieces
+BitbaseResult probe_bitbase(gameState & state);
+
+//PRE : state must be populated correctly
+//POST: returns TRUE and sets whiteScore if state is a bitbase ending
+//DESC: A draw is 0. A win is KNOWN_WIN_SCORE plus the winning side's material plus a bonus for progress:
+//      the pawn's advance, or the losing king's distance from the center (the right corner for KBNK) and
+//      the kings' closeness, so the search has a gradient to follow toward the mate
+bool bitbase_score(gameState & state, int & whiteScore);
+
+#endif
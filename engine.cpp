@@ -0,0 +1,96 @@
+#include "engine.h"
+#include <algorithm>
+
+MemoryPlan plan_memory(int memoryMB){
+  MemoryPlan plan;
+  plan.memoryMB = memoryMB;
+  int tablesMB = max(3, memoryMB - ENGINE_FIXED_MB);
+  plan.pawnTableMB = max(1, tablesMB / 64);
+  plan.evalCacheMB = max(1, tablesMB / 16);
+  plan.transpositionTableMB = max(1, tablesMB - plan.pawnTableMB - plan.evalCacheMB);
+  return plan;
+}
+
+Engine::Engine(int memoryMB)
+  : plan(plan_memory(memoryMB)), search(plan.pawnTableMB, plan.evalCacheMB, plan.transpositionTableMB){
+  position.populate_board(STARTING_FEN);
+  position.isFirstMove = true;
+  //A library reports iterations through start's callback, not the log
+  search.options.printIterations = false;
+}
+
+Engine::~Engine(){
+  stop();
+  lock_guard<mutex> guard(lock);
+  if(worker.joinable()) worker.join();
+}
+
+bool Engine::set_position(const string & fen, const vector<string> & moves){
+  position.populate_board(fen);
+  position.isFirstMove = moves.empty();
+  gameKeys.clear();
+  gameState next = position;
+  for(size_t k = 0; k < moves.size(); k++){
+    //Only a move the position actually has is played, anything else leaves the engine at fen
+    const string & text = moves[k];
+    bool wellFormed = text.length() >= 4 && text[0] >= 'a' && text[0] <= 'h' && text[1] >= '1' && text[1] <= '8' &&
+                      text[2] >= 'a' && text[2] <= 'h' && text[3] >= '1' && text[3] <= '8';
+    Move move = (wellFormed ? uci_to_move(text) : NO_MOVE);
+    MoveList legal;
+    next.generate_moves(legal, next.active_color);
+    if(move == NO_MOVE || find(legal.moves, legal.moves + legal.count, move) == legal.moves + legal.count){
+      gameKeys.clear();
+      return false;
+    }
+    gameKeys.push_back(next.key);
+    next.apply_move(move);
+  }
+  position = next;
+  return true;
+}
+
+bool Engine::set_game(const string & fen, const vector<string> & history){
+  gameState current;
+  current.populate_board(fen);
+  if(set_position(STARTING_FEN, history) && position.key == current.key) return true;
+  set_position(fen);
+  return false;
+}
+
+shared_future<string> Engine::start(const SearchLimits & limits, function<void(const SearchInfo &)> onInfo){
+  lock_guard<mutex> guard(lock);
+  if(worker.joinable()) worker.join();
+  if(limits.clockSeconds > 0){
+    timeManager.start(limits.clockSeconds, position.fullmove_number - 1);
+  } else {
+    timeManager.start_fixed(limits.moveSeconds > 0 ? limits.moveSeconds : UNLIMITED_SECONDS);
+  }
+  search.options.nodeLimit = limits.nodes;
+  search.options.onIteration = onInfo;
+  int depth = (limits.depth > 0 ? min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1);
+
+  promise<string> bestMove;
+  result = bestMove.get_future().share();
+  worker = thread([this, depth, bestMove = std::move(bestMove)]() mutable {
+    bestMove.set_value(search.best_move(position, gameKeys, depth, timeManager));
+  });
+  return result;
+}
+
+void Engine::stop(){
+  timeManager.stop();
+}
+
+bool Engine::searching(){
+  lock_guard<mutex> guard(lock);
+  return result.valid() && result.wait_for(chrono::seconds(0)) != future_status::ready;
+}
+
+string Engine::wait(){
+  shared_future<string> move;
+  {
+    lock_guard<mutex> guard(lock);
+    move = result;
+  }
+  return move.get();
+}
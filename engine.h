@@ -0,0 +1,97 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+#include <future>
+#include <mutex>
+#include <thread>
+#include "search.h"
+
+const double UNLIMITED_SECONDS = 1e7;  //Clock of a search with no time limit, about four months
+const int DEFAULT_ENGINE_MEMORY_MB = 72;  //Gives the default 64MB transposition table, 4MB eval cache and 1MB pawn table
+const int ENGINE_FIXED_MB = 1;            //Arena, history and reduction tables and the bitbases, rounded up
+
+//How an engine's memory budget is split between its tables
+struct MemoryPlan {
+  int memoryMB;              //The whole budget
+  int pawnTableMB;
+  int evalCacheMB;
+  int transpositionTableMB;
+};
+
+//PRE : None
+//POST: returns the split of memoryMB, every table getting at least 1MB
+//DESC: After the fixed part the pawn table gets a 64th, the evaluation cache a 16th and the transposition
+//      table the rest. Tables round down to a power of two entries, so they never use more than planned
+MemoryPlan plan_memory(int memoryMB);
+
+//Limits of one search. A limit left at 0 does not apply, and with none at all the search runs until stopped
+struct SearchLimits {
+  double clockSeconds = 0;   //Time left on the player's clock, split between moves by the time manager
+  double moveSeconds = 0;    //Fixed time for this search, used when clockSeconds is 0
+  int depth = 0;             //Deepest iteration
+  long nodes = 0;            //Stop after about this many nodes
+};
+
+//The engine as a library: a position, a search with its own tables, and a thread to search on.
+//Searches run in the background and hand back a future, so a caller never blocks unless it asks for the
+//move. Engines share nothing writable, so a process can hold as many as its memory allows.
+class Engine{
+  public:
+    gameState position;          //Position the next search starts from
+    vector<uint64_t> gameKeys;   //Keys of the positions played before position, oldest first
+    const MemoryPlan plan;       //How memoryMB was split between the tables
+    Search search;               //The search and its caches, kept between searches. Read its results once done
+    TimeManager timeManager;     //Clock of the current or last search
+
+    //PRE : None
+    //POST: the tables are allocated from memoryMB as plan_memory splits it and position is the starting position
+    Engine(int memoryMB = DEFAULT_ENGINE_MEMORY_MB);
+
+    //PRE : None
+    //POST: a running search is stopped and waited for
+    ~Engine();
+
+    //PRE : no search may be running. fen must be in fen notation, moves must be in UCI notation
+    //POST: returns FALSE and leaves position at fen if one of the moves is not legal, TRUE with position
+    //      after the moves and gameKeys holding the positions before it if they all are
+    //DESC: Set the position the way a UCI "position fen ... moves ..." command does
+    bool set_position(const string & fen, const vector<string> & moves = vector<string>());
+
+    //PRE : no search may be running. fen must be in fen notation, history must be the game's moves from the
+    //      starting position in UCI notation
+    //POST: position is fen. returns TRUE with gameKeys holding the positions before it if history leads
+    //      there, FALSE with gameKeys empty if it does not
+    //DESC: Set the position of a game as a server sends it, so the search knows which positions have already
+    //      happened. If the history does not lead to fen the game started somewhere else, so it goes from fen alone
+    bool set_game(const string & fen, const vector<string> & history);
+
+    //PRE : no search may be running, the side to move must have a valid move
+    //POST: a search of position has started on the engine's thread, its best move in UCI notation will be
+    //      in the returned future. onInfo, if given, is called on that thread after every finished iteration
+    //DESC: Returns right away. The clock starts now, not when the thread gets going
+    shared_future<string> start(const SearchLimits & limits,
+                                function<void(const SearchInfo &)> onInfo = function<void(const SearchInfo &)>());
+
+    //PRE : None
+    //POST: a running search finishes within about a thousand nodes and gives the best move it has
+    //DESC: Safe to call from any thread, and does nothing if no search is running
+    void stop();
+
+    //PRE : None
+    //POST: returns TRUE if a search has been started and its move is not ready yet
+    bool searching();
+
+    //PRE : start must have been called
+    //POST: returns the best move of the last search once it is done
+    //DESC: Blocks until the search finishes
+    string wait();
+
+  private:
+    thread worker;               //Thread of the last search, joined before the next one starts
+    shared_future<string> result;
+    mutex lock;                  //Guards worker and result between start, stop and wait
+
+    Engine(const Engine &);
+    Engine & operator=(const Engine &);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "engine_host.h"
+#include <algorithm>
+#include <chrono>
+#include "memory_accounting.h"
+
+GameContext::GameContext(int memoryMB) : engine(memoryMB){
+}
+
+void GameContext::set_position(const string & fen, const vector<string> & history){
+  engine.set_game(fen, history);
+}
+
+EngineHost::EngineHost(int memoryMB, int threads){
+  memoryBudgetMB = max(1, memoryMB);
+  memoryPlannedMB = 0;
+  threadBudget = max(1, threads);
+  threadsBusy = 0;
+}
+
+EngineHost::~EngineHost(){
+  for(size_t k = 0; k < games.size(); k++){
+    delete games[k];
+  }
+}
+
+GameContext * EngineHost::open_game(int memoryMB){
+  int gameMB = max(MIN_GAME_MEMORY_MB, memoryMB);
+  {
+    lock_guard<mutex> guard(lock);
+    while(gameMB > MIN_GAME_MEMORY_MB && memoryPlannedMB + gameMB > memoryBudgetMB){
+      gameMB = max(MIN_GAME_MEMORY_MB, gameMB / 2);
+    }
+    if(memoryPlannedMB + gameMB > memoryBudgetMB){
+      return NULL;
+    }
+    //Charge the budget before allocating so another thread cannot take the same room
+    memoryPlannedMB += gameMB;
+  }
+  //Allocating and zeroing the tables takes a while, so it happens outside the lock
+  GameContext * game = new GameContext(gameMB);
+  lock_guard<mutex> guard(lock);
+  games.push_back(game);
+  return game;
+}
+
+void EngineHost::close_game(GameContext * game){
+  if(game == NULL) return;
+  {
+    lock_guard<mutex> guard(lock);
+    vector<GameContext *>::iterator it = find(games.begin(), games.end(), game);
+    if(it == games.end()) return;
+    games.erase(it);
+    memoryPlannedMB -= game->engine.plan.memoryMB;
+  }
+  delete game;
+}
+
+string EngineHost::think(GameContext & game, double secondsLeft, int maxDepth){
+  //The game's clock is already running while it waits for a thread, so the wait comes out of its time
+  chrono::steady_clock::time_point asked = chrono::steady_clock::now();
+  {
+    unique_lock<mutex> guard(lock);
+    while(threadsBusy >= threadBudget){
+      threadFree.wait(guard);
+    }
+    threadsBusy++;
+  }
+  SearchLimits limits;
+  double waited = chrono::duration<double>(chrono::steady_clock::now() - asked).count();
+  limits.clockSeconds = max(0.001, secondsLeft - waited);
+  limits.depth = maxDepth;
+  game.engine.start(limits);
+  string best = game.engine.wait();
+  {
+    lock_guard<mutex> guard(lock);
+    threadsBusy--;
+  }
+  threadFree.notify_one();
+  return best;
+}
+
+int EngineHost::memory_used(){
+  return int(memory_charged_total() / (1024 * 1024));
+}
+
+int EngineHost::game_count(){
+  lock_guard<mutex> guard(lock);
+  return int(games.size());
+}
@@ -0,0 +1,86 @@
+#ifndef ENGINE_HOST_H
+#define ENGINE_HOST_H
+#include <condition_variable>
+#include <mutex>
+#include "engine.h"
+
+const int DEFAULT_HOST_MEMORY_MB = 1024;
+const int MIN_GAME_MEMORY_MB = ENGINE_FIXED_MB + 3;  //Smallest budget plan_memory keeps to, 1MB for each table
+
+//One game served by an EngineHost. Everything that changes during a game lives in its Engine, so games never
+//share writable state. The attack tables, Zobrist keys and evaluation weights are compile time constants that
+//live once in the program image and are read by every game.
+class GameContext{
+  public:
+    Engine engine;               //This game's position, history, search and tables
+
+    //PRE : memoryMB must be at least MIN_GAME_MEMORY_MB
+    //POST: the game's tables are allocated from memoryMB and the position is the starting position
+    //DESC: Only made by EngineHost::open_game, which checks the budget first
+    GameContext(int memoryMB);
+
+    //PRE : no search of the game may be running. fen must be in fen notation, history must be the game's
+    //      moves from the starting position in UCI notation
+    //POST: the engine's position is fen, with the positions before it if history leads there
+    //DESC: Called before each move with the game as the server sees it, see Engine::set_game
+    void set_position(const string & fen, const vector<string> & history);
+
+  private:
+    GameContext(const GameContext &);
+    GameContext & operator=(const GameContext &);
+};
+
+//Serves many games from one process. The host keeps the total memory of every game's tables under one
+//budget and lets only so many searches run at once, so dozens of games fit on a machine without each one
+//sizing itself as if it had the machine to itself.
+class EngineHost{
+  public:
+    //PRE : memoryMB and threads must be at least 1
+    //POST: the host is empty
+    //DESC: memoryMB covers the tables of every open game, threads is the most searches running at once
+    EngineHost(int memoryMB = DEFAULT_HOST_MEMORY_MB, int threads = 1);
+
+    //PRE : None
+    //POST: every game still open is closed
+    ~EngineHost();
+
+    //PRE : None
+    //POST: returns a new game, or NULL if the budget has no room for even the smallest game
+    //DESC: The game's memoryMB is halved until it fits in what is left of the budget, then split between
+    //      its tables by plan_memory
+    GameContext * open_game(int memoryMB = DEFAULT_ENGINE_MEMORY_MB);
+
+    //PRE : game must have come from open_game and must not be searching
+    //POST: game is deleted and its memory is returned to the budget
+    void close_game(GameContext * game);
+
+    //PRE : game must be open, set_position must have been called and the side to move must have a valid move
+    //POST: returns the best move in UCI notation for game's position
+    //DESC: Waits for a free search thread, then searches on the game's engine with secondsLeft on the clock,
+    //      less the time spent waiting. Safe to call from many threads at once as long as each game is only
+    //      searched by one of them
+    string think(GameContext & game, double secondsLeft, int maxDepth = MAX_PLY - 1);
+
+    //PRE : None
+    //POST: returns the megabytes the process's tables really hold, as charged to memory_accounting.h
+    //DESC: Tables round down to a power of two entries, so this is at most the budget given to the open games
+    int memory_used();
+
+    //PRE : None
+    //POST: returns the number of open games
+    int game_count();
+
+  private:
+    mutex lock;                     //Guards everything below
+    condition_variable threadFree;  //Signalled when a search finishes
+    int memoryBudgetMB;
+    int memoryPlannedMB;            //Sum of the open games' budgets, what open_game checks against memoryBudgetMB
+    int threadBudget;
+    int threadsBusy;
+    vector<GameContext *> games;
+
+    EngineHost(const EngineHost &);
+    EngineHost & operator=(const EngineHost &);
+};
+
+#endif
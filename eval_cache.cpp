@@ -0,0 +1,44 @@
+#include "eval_cache.h"
+#include "memory_accounting.h"
+
+EvalCache::EvalCache(int sizeMB){
+  uint64_t count = 1;
+  while(count * 2 * sizeof(EvalEntry) <= uint64_t(sizeMB) * 1024 * 1024){
+    count *= 2;
+  }
+  entries.resize(count);
+  mask = count - 1;
+  memory_charge(MEMORY_EVAL_CACHE, entries.size() * sizeof(EvalEntry));
+  clear();
+}
+
+EvalCache::~EvalCache(){
+  memory_charge(MEMORY_EVAL_CACHE, -(long long)(entries.size() * sizeof(EvalEntry)));
+}
+
+void EvalCache::clear(){
+  //A key of 0 marks an empty entry. A real position hashing to exactly 0 is too unlikely to matter
+  for(size_t i = 0; i < entries.size(); i++){
+    entries[i].key = 0;
+    entries[i].score = 0;
+  }
+  probes = 0;
+  hits = 0;
+}
+
+bool EvalCache::probe(uint64_t key, int & score){
+  probes++;
+  EvalEntry & entry = entries[key & mask];
+  if(entry.key == key && key != 0){
+    hits++;
+    score = entry.score;
+    return true;
+  }
+  return false;
+}
+
+void EvalCache::store(uint64_t key, int score){
+  EvalEntry & entry = entries[key & mask];
+  entry.key = key;
+  entry.score = score;
+}
@@ -0,0 +1,50 @@
+#ifndef EVAL_CACHE_H
+#define EVAL_CACHE_H
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+//One stored evaluation
+struct EvalEntry {
+  uint64_t key;  //gameState::key of the evaluated position
+  int score;     //evaluate() of the position, from the point of view of the color to move
+};
+
+//Hash table of static evaluations indexed by gameState::key. Each search owns its own cache,
+//so it is never shared between threads and needs no locking.
+//Iterative deepening and transpositions evaluate the same positions many times, this makes the repeats free.
+class EvalCache{
+  public:
+    long probes;  //Number of lookups since the last clear
+    long hits;    //Number of lookups that found the position
+
+    //PRE : sizeMB must be at least 1
+    //POST: cache is allocated with the largest power of two number of entries that fits in sizeMB
+    //DESC: Create an empty evaluation cache
+    EvalCache(int sizeMB = 4);
+    ~EvalCache();
+
+    //PRE : None
+    //POST: every entry is empty, counters are reset
+    //DESC: Forget every stored evaluation
+    void clear();
+
+    //PRE : None
+    //POST: returns TRUE and sets score if key is stored, returns FALSE if not
+    //DESC: Look up the evaluation of a position
+    bool probe(uint64_t key, int & score);
+
+    //PRE : None
+    //POST: key and score replace whatever was stored in the key's entry
+    //DESC: Remember the evaluation of a position
+    void store(uint64_t key, int score);
+
+  private:
+    vector<EvalEntry> entries;
+    uint64_t mask;  //entries.size() - 1, used to turn a key into an index
+
+    EvalCache(const EvalCache &);
+    EvalCache & operator=(const EvalCache &);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "eval_weights.h"
+
+//Evaluation weights in centipawns. tools/texel_tuner.cpp writes this file, hand edits are fine between runs
+const EvalWeights EVAL_WEIGHTS = {
+  //pieceValue
+  {100, 320, 330, 500, 900, 0},
+  //placement
+  {
+    //pawn
+    {{  0,  0,  0,  0,  0,  0,  0,  0},
+     { 50, 50, 50, 50, 50, 50, 50, 50},
+     { 10, 10, 20, 30, 30, 20, 10, 10},
+     {  5,  5, 10, 25, 25, 10,  5,  5},
+     {  0,  0,  0, 20, 20,  0,  0,  0},
+     {  5, -5,-10,  0,  0,-10, -5,  5},
+     {  5, 10, 10,-20,-20, 10, 10,  5},
+     {  0,  0,  0,  0,  0,  0,  0,  0}},
+    //knight
+    {{-50,-40,-30,-30,-30,-30,-40,-50},
+     {-40,-20,  0,  0,  0,  0,-20,-40},
+     {-30,  0, 10, 15, 15, 10,  0,-30},
+     {-30,  5, 15, 20, 20, 15,  5,-30},
+     {-30,  0, 15, 20, 20, 15,  0,-30},
+     {-30,  5, 10, 15, 15, 10,  5,-30},
+     {-40,-20,  0,  5,  5,  0,-20,-40},
+     {-50,-40,-30,-30,-30,-30,-40,-50}},
+    //bishop
+    {{-20,-10,-10,-10,-10,-10,-10,-20},
+     {-10,  0,  0,  0,  0,  0,  0,-10},
+     {-10,  0,  5, 10, 10,  5,  0,-10},
+     {-10,  5,  5, 10, 10,  5,  5,-10},
+     {-10,  0, 10, 10, 10, 10,  0,-10},
+     {-10, 10, 10, 10, 10, 10, 10,-10},
+     {-10,  5,  0,  0,  0,  0,  5,-10},
+     {-20,-10,-10,-10,-10,-10,-10,-20}},
+    //rook
+    {{  0,  0,  0,  0,  0,  0,  0,  0},
+     {  5, 10, 10, 10, 10, 10, 10,  5},
+     { -5,  0,  0,  0,  0,  0,  0, -5},
+     { -5,  0,  0,  0,  0,  0,  0, -5},
+     { -5,  0,  0,  0,  0,  0,  0, -5},
+     { -5,  0,  0,  0,  0,  0,  0, -5},
+     { -5,  0,  0,  0,  0,  0,  0, -5},
+     {  0,  0,  0,  5,  5,  0,  0,  0}},
+    //queen
+    {{-20,-10,-10, -5, -5,-10,-10,-20},
+     {-10,  0,  0,  0,  0,  0,  0,-10},
+     {-10,  0,  5,  5,  5,  5,  0,-10},
+     { -5,  0,  5,  5,  5,  5,  0, -5},
+     {  0,  0,  5,  5,  5,  5,  0, -5},
+     {-10,  5,  5,  5,  5,  5,  0,-10},
+     {-10,  0,  5,  0,  0,  0,  0,-10},
+     {-20,-10,-10, -5, -5,-10,-10,-20}},
+    //king
+    {{-30,-40,-40,-50,-50,-40,-40,-30},
+     {-30,-40,-40,-50,-50,-40,-40,-30},
+     {-30,-40,-40,-50,-50,-40,-40,-30},
+     {-30,-40,-40,-50,-50,-40,-40,-30},
+     {-20,-30,-30,-40,-40,-30,-30,-20},
+     {-10,-20,-20,-20,-20,-20,-20,-10},
+     { 20, 20,  0,  0,  0,  0, 20, 20},
+     { 20, 30, 10,  0,  0, 10, 30, 20}}
+  },
+  //passedBonus
+  {0, 5, 10, 20, 35, 60, 100, 0},
+  //isolatedPenalty, doubledPenalty, backwardPenalty
+  15, 12, 10,
+  //shieldNearBonus, shieldFarBonus, shieldMissingPenalty
+  12, 6, 12
+};
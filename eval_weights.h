@@ -0,0 +1,46 @@
+#ifndef EVAL_WEIGHTS_H
+#define EVAL_WEIGHTS_H
+
+//Order of the piece types in the weight tables
+enum { PAWN_TYPE = 0, KNIGHT_TYPE = 1, BISHOP_TYPE = 2, ROOK_TYPE = 3, QUEEN_TYPE = 4, KING_TYPE = 5 };
+
+//Every number the evaluation adds up, in centipawns. The evaluation is each weight times the number
+//of times it applies, so the same struct filled with counts (EvalTrace) is all tools/texel_tuner.cpp
+//needs to tune them. Only int members, so the tuner can treat it as one array
+struct EvalWeights {
+  int pieceValue[6];        //Material, by piece type. The king's is never used
+  int placement[6][8][8];   //Placement bonus by piece type, from white's side of the board, row 0 is the 8th rank
+  int passedBonus[8];       //Passed pawn, by number of rows advanced from the start row
+  int isolatedPenalty;
+  int doubledPenalty;
+  int backwardPenalty;
+  int shieldNearBonus;      //Pawn directly in front of a back rank king, per file next to and on the king's file
+  int shieldFarBonus;       //Pawn two rows in front of the king
+  int shieldMissingPenalty; //Neither
+};
+
+//Counts of how often each weight applies to a position, white minus black
+struct EvalTrace {
+  EvalWeights counts;
+  int shield[2][8][3];      //Near, far and missing shield counts in front of each back rank file, by color
+};
+
+//Weights used by evaluate(), defined in eval_weights.cpp which tools/texel_tuner.cpp writes
+extern const EvalWeights EVAL_WEIGHTS;
+
+//PRE : None
+//POST: returns PAWN_TYPE to KING_TYPE for a piece of either color, -1 for a blank space
+//DESC: Index of a board character in the weight tables
+inline int piece_type(char piece){
+  switch(piece){
+    case 'P': case 'p': return PAWN_TYPE;
+    case 'N': case 'n': return KNIGHT_TYPE;
+    case 'B': case 'b': return BISHOP_TYPE;
+    case 'R': case 'r': return ROOK_TYPE;
+    case 'Q': case 'q': return QUEEN_TYPE;
+    case 'K': case 'k': return KING_TYPE;
+  }
+  return -1;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include "evaluate.h"
+#include "bitbase.h"
+
+int piece_value(char piece){
+  int type = piece_type(piece);
+  return (type < 0 || type == KING_TYPE) ? 0 : EVAL_WEIGHTS.pieceValue[type];
+}
+
+int evaluate(gameState & state, const string & color, PawnTable & pawnTable, EvalTrace * trace){
+  //Endings in the bitbases have a known result. A trace must stay a sum of the weights, so it skips them
+  int knownScore;
+  if(trace == NULL && bitbase_score(state, knownScore)){
+    return (color == "white" ? knownScore : -knownScore);
+  }
+
+  int score = 0;  //Score from white's point of view
+  int whiteKingx = -1, whiteKingy = -1;
+  int blackKingx = -1, blackKingy = -1;
+
+  //Material and placement of every piece, from the piece lists
+  const char * pieces = "PNBRQKpnbrqk";
+  for(int p = 0; p < 12; p++){
+    char piece = pieces[p];
+    bool white = (p < 6);
+    int type = piece_type(piece);
+    int value = piece_value(piece);
+    for(int n = 0; n < state.pieceCount[p]; n++){
+      int i = state.pieceSquares[p][n] / 8;
+      int j = state.pieceSquares[p][n] % 8;
+      int row = (white ? i : 7 - i);  //Black pieces use the tables with the rows flipped
+      int placed = value + EVAL_WEIGHTS.placement[type][row][j];
+      score += (white ? placed : -placed);
+      if(trace != NULL){
+        if(type != KING_TYPE) trace->counts.pieceValue[type] += (white ? 1 : -1);
+        trace->counts.placement[type][row][j] += (white ? 1 : -1);
+      }
+      if(piece == 'K'){ whiteKingx = i; whiteKingy = j; }
+      if(piece == 'k'){ blackKingx = i; blackKingy = j; }
+    }
+  }
+
+  //Pawn structure, and the pawn shield of a king still on its back rank.
+  //A trace needs the pawn counts, so it skips the pawn table
+  PawnEntry traced;
+  if(trace != NULL){
+    evaluate_pawns(state.gameBoard, traced, trace);
+  }
+  PawnEntry & pawns = (trace != NULL ? traced : pawnTable.probe(state.gameBoard, state.pawnKey));
+  score += pawns.score;
+  if(whiteKingx == 7) score += pawns.shield[WHITE][whiteKingy];
+  if(blackKingx == 0) score -= pawns.shield[BLACK][blackKingy];
+  if(trace != NULL){
+    int * shieldWeights[3] = {&trace->counts.shieldNearBonus, &trace->counts.shieldFarBonus,
+                              &trace->counts.shieldMissingPenalty};
+    for(int k = 0; k < 3; k++){
+      if(whiteKingx == 7) *shieldWeights[k] += trace->shield[WHITE][whiteKingy][k];
+      if(blackKingx == 0) *shieldWeights[k] -= trace->shield[BLACK][blackKingy][k];
+    }
+  }
+
+  return (color == "white" ? score : -score);
+}
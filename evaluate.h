@@ -0,0 +1,18 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+#include "game_logic.h"
+#include "pawn_table.h"
+#include "eval_weights.h"
+
+//PRE : None
+//POST: returns the material value of the piece in centipawns, 0 for a king or blank
+//DESC: Material value of a board character of either color
+int piece_value(char piece);
+
+//PRE : state must be populated correctly, color must be "black" or "white", trace must be zeroed if given
+//POST: returns the static score of the position in centipawns, positive if good for color.
+//      If trace is given it holds how many times each weight was used, white minus black
+//DESC: Material, piece placement and pawn structure. Pawn structure is looked up in pawnTable
+int evaluate(gameState & state, const string & color, PawnTable & pawnTable, EvalTrace * trace = NULL);
+
+#endif
@@ -1,4 +1,5 @@
 #include "game_logic.h"
+#include "logger.h"
 
 void gameState::populate_board(const string fen){
   //extrapolate lines from the fen string
@@ -19,8 +20,12 @@ void gameState::populate_board(const string fen){
   }
 
   //set the correct move strings
+  active_color = (extra_moves[1] == "b" ? "black" : "white");
   castling = extra_moves[2];
   en_passant = extra_moves[3];
+  //The move counters are optional in some fen strings
+  halfmove_clock = (extra_moves.size() > 4 ? stoi(extra_moves[4]) : 0);
+  fullmove_number = (extra_moves.size() > 5 ? stoi(extra_moves[5]) : 1);
 
   //Replace numbers with the appropriate number of blank spaces
   for(int i = 0; i < lines.size(); i++){
@@ -48,717 +53,545 @@ void gameState::populate_board(const string fen){
       }
     }
   }
-}
 
-//Print the current board datastructure
-void gameState::print_board(){
-  cout << "  a b c d e f g h\n";
-  for(int i = 0; i < 8; i++){
-    cout << (8-i) << " ";
-    for (int j = 0; j < 8; j++){
-      cout << gameBoard[i][j] << " ";
-    }
-    cout << "\n";
-  }
+  index_pieces();
+  compute_keys();
 }
 
-void gameState::get_valid_moves(vector<string> & valid_moves, string color, char gameBoard[][8]){
-  //If the castling string is not blank, generate moves indicated
-  if(castling != "-"){
-    get_castling_moves(valid_moves);
-  }
-  //If the en_passant string is not blank, generate moves indicated
-  if(en_passant != "-"){
-    get_en_passant_moves(valid_moves, color);
+void gameState::index_pieces(){
+  for(int p = 0; p < 12; p++){
+    pieceCount[p] = 0;
   }
-  //For each piece on the board
   for(int i = 0; i < 8; i++){
     for(int j = 0; j < 8; j++){
-      //If the current space is not a blank
-      if(gameBoard[i][j] != '-'){
-        //Generate all moves for appropriate piece and color
-        if(color == "white"){
-          switch(gameBoard[i][j]){
-            case 'P':
-              get_pawn_moves(valid_moves, color, i, j);
-              break;
-            case 'N':
-              get_knight_moves(valid_moves, color, i, j);
-              break;
-            case 'B':
-              get_bishop_moves(valid_moves, color, i, j);
-              break;
-            case 'R':
-              get_rook_moves(valid_moves, color, i, j);
-              break;
-            case 'Q':
-              get_queen_moves(valid_moves, color, i, j);
-              break;
-            case 'K':
-              get_king_moves(valid_moves, color, i, j);
-              //For debugging, is the King in Check?
-              //cout << "Is King in Check? " << isKingCheck(gameBoard, color, i, j) << endl;
-              break;
-          }
-        } else if(color == "black"){
-          switch(gameBoard[i][j]){
-            case 'p':
-              get_pawn_moves(valid_moves, color, i, j);
-              break;
-            case 'n':
-              get_knight_moves(valid_moves, color, i, j);
-              break;
-            case 'b':
-              get_bishop_moves(valid_moves, color, i, j);
-              break;
-            case 'r':
-              get_rook_moves(valid_moves, color, i, j);
-              break;
-            case 'q':
-              get_queen_moves(valid_moves, color, i, j);
-              break;
-            case 'k':
-              get_king_moves(valid_moves, color, i, j);
-              // For debugging, is the King in Check?
-              //cout << "Is King in Check? " << isKingCheck(gameBoard, color, i, j) << endl;
-              break;
-          }
-        }
-      }
+      int p = piece_index(gameBoard[i][j]);
+      if(p < 0 || pieceCount[p] == MAX_PIECES_OF_TYPE) continue;
+      listIndex[i*8 + j] = pieceCount[p];
+      pieceSquares[p][pieceCount[p]++] = uint8_t(i*8 + j);
     }
   }
 }
 
-void gameState::get_pawn_moves(vector<string> & valid_moves, string color, int x, int y){
-  char dupBoard[8][8];     //Board used to simulate the move and check for check
-  bool pieceTaken = false; //Indicates whether a peice will be taken for the move
-  int kingx;  //King's position x
-  int kingy;  //King's position y
+int gameState::king_square(const string & color){
+  return pieceSquares[piece_index(color == "white" ? 'K' : 'k')][0];
+}
 
-  if(color == "white"){ //If white, move up
-    //Check if a single space forward is a valid move
-    if(gameBoard[x-1][y] == '-' && x-1 < 8 && y < 8 && x-1 >= 0 && y >= 0){
-      //Copy the board to simulate the move
-      copyBoard(gameBoard, dupBoard, 'P', x, y, x-1, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, it is a valid move
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-1,y));
-      }
-    }
-    //If the pawn is in file 2, check if it is able to move 2 spaces
-    if(x == 6 && gameBoard[x-1][y] == '-' && gameBoard[x-2][y] == '-' && x-2 < 8 && y < 8 && x-2 >= 0 && y >= 0){
-      //copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, 'P', x, y, x-2, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, it is a valid move
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-2,y));
-      }
-    }
-    //If there is an enemy piece on a diagonal, check the space
-    if(isEnemyPiece(gameBoard[x-1][y+1], color) && check_space(gameBoard, color, x-1, y+1, pieceTaken)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, 'P', x, y, x-1, y+1);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, it is a valid move
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-1,y+1));
-      }
-    }
-    //Check other diagonal
-    if(isEnemyPiece(gameBoard[x-1][y-1], color) && check_space(gameBoard, color, x-1, y-1, pieceTaken)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, 'P', x, y, x-1, y-1);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //if king not in check, valid move
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-1,y-1));
+void gameState::compute_keys(){
+  key = 0;
+  pawnKey = 0;
+  for(int i = 0; i < 8; i++){
+    for(int j = 0; j < 8; j++){
+      if(gameBoard[i][j] == '-') continue;
+      key ^= ZOBRIST.piece[piece_index(gameBoard[i][j])][i*8 + j];
+      if(gameBoard[i][j] == 'P' || gameBoard[i][j] == 'p'){
+        pawnKey ^= ZOBRIST.piece[piece_index(gameBoard[i][j])][i*8 + j];
       }
     }
   }
-  else if(color == "black"){ //If black move down
-    //Check if a single space forward is a valid move
-    if(gameBoard[x+1][y] == '-' && x+1 < 8 && y < 8 && x+1 >= 0 && y >= 0){
-      //copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, 'p', x, y, x+1, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //if  the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+1,y));
-      }
-    }
-    //If the pawn is in file 7, check if it can move 2 spaces
-    if(x == 1 && gameBoard[x+1][y] == '-' && gameBoard[x+2][y] == '-' && x+2 < 8 && y < 8 && x+2 >= 0 && y >= 0){
-      //copy the board to simulate a move
-      copyBoard(gameBoard, dupBoard, 'p', x, y, x+2, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //if the king is not in check, valid move
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+2,y));
-      }
-    }
-    //if an enemy piece is on a diagonal, and move is legal
-    if(isEnemyPiece(gameBoard[x+1][y+1], color) && check_space(gameBoard, color, x+1, y+1, pieceTaken)){
-      //copy and simulate
-      copyBoard(gameBoard, dupBoard, 'p', x, y, x+1, y+1);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //if king not in check, valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+1,y+1));
-      }
-    }
-    //Check other diagonal
-    if(isEnemyPiece(gameBoard[x+1][y-1], color) && check_space(gameBoard, color, x+1, y-1, pieceTaken)){
-      //Copy, simulate move
-      copyBoard(gameBoard, dupBoard, 'p', x, y, x+1, y-1);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //if king not in check, valid move
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+1,y-1));
-      }
-    }
+  toggle_state_keys();
+  if(active_color == "black"){
+    key ^= ZOBRIST.side;
   }
 }
 
-void gameState::get_knight_moves(vector<string> & valid_moves, string color, int x, int y){
-  bool pieceTaken = false;  //indicates if move will take an enemy peice 
-  char dupBoard[8][8];      //space to duplucate the board and simulate a move
-  int kingx;
-  int kingy;
-  //Check all 8 valid positions manually
-  
-  if(check_space(gameBoard, color, x+2, y+1, pieceTaken)){
-    //Copy and simulate move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x+2, y+1);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //If king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x+2,y+1));
-    }
+void gameState::toggle_state_keys(){
+  key ^= ZOBRIST.castling[castling_mask(castling)];
+  if(en_passant != "-"){
+    key ^= ZOBRIST.en_passant[en_passant[0] - 'a'];
   }
-  if(check_space(gameBoard, color, x+2, y-1, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x+2, y-1);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x+2,y-1));
-    }
+}
+
+void gameState::apply_move(const string move){
+  apply_move(uci_to_move(move));
+}
+
+void gameState::apply_move(Move move){
+  //Unpack the move to board positions
+  int startx = move_from(move)/8;
+  int starty = move_from(move)%8;
+  int x = move_to(move)/8;
+  int y = move_to(move)%8;
+  char piece = gameBoard[startx][starty];
+  bool white = (piece >= 'A' && piece <= 'Z');
+  bool isPawn = (piece == 'P' || piece == 'p');
+  toggle_state_keys();
+
+  //Pawn moves and captures can never be undone, so positions before them can not repeat
+  if(isPawn || gameBoard[x][y] != '-'){
+    halfmove_clock = 0;
+  } else {
+    halfmove_clock++;
+  }
+  if(!white){
+    fullmove_number++;
+  }
+
+  //A pawn moving diagonally onto a blank space is taking en passant
+  if(isPawn && starty != y && gameBoard[x][y] == '-'){
+    remove_piece(startx, y);
+  }
+  if(gameBoard[x][y] != '-'){
+    remove_piece(x, y);
+  }
+  remove_piece(startx, starty);
+  //Replace a promoted pawn with its new piece
+  if(isPawn && move_promotion(move) != PROMOTE_NONE){
+    char promoted = "-nbrq"[move_promotion(move)];
+    piece = (white ? char(toupper(promoted)) : promoted);
+  }
+  put_piece(x, y, piece);
+
+  //A king moving two spaces is castling, so move the rook to the other side of the king
+  if((piece == 'K' || piece == 'k') && (y - starty == 2 || starty - y == 2)){
+    int rooky = (y > starty ? 7 : 0);
+    char rook = gameBoard[x][rooky];
+    remove_piece(x, rooky);
+    put_piece(x, (starty + y)/2, rook);
+  }
+
+  //Remove castling rights for a king that moved, or a rook that moved or was taken
+  string rights = "";
+  for(size_t i = 0; i < castling.length(); i++){
+    char right = castling[i];
+    if((right == 'K' || right == 'Q') && piece == 'K') continue;
+    if((right == 'k' || right == 'q') && piece == 'k') continue;
+    if(right == 'K' && ((startx == 7 && starty == 7) || (x == 7 && y == 7))) continue;
+    if(right == 'Q' && ((startx == 7 && starty == 0) || (x == 7 && y == 0))) continue;
+    if(right == 'k' && ((startx == 0 && starty == 7) || (x == 0 && y == 7))) continue;
+    if(right == 'q' && ((startx == 0 && starty == 0) || (x == 0 && y == 0))) continue;
+    if(right != '-') rights.push_back(right);
+  }
+  castling = (rights == "" ? "-" : rights);
+
+  //A pawn moving two spaces can be taken en passant on the space it skipped
+  if(isPawn && (x - startx == 2 || startx - x == 2)){
+    en_passant = move_string(0, 0, (startx + x)/2, y).substr(2, 2);
+  } else {
+    en_passant = "-";
+  }
+  toggle_state_keys();
+  active_color = (active_color == "white" ? "black" : "white");
+  key ^= ZOBRIST.side;
+}
+
+void gameState::apply_null_move(){
+  toggle_state_keys();
+  en_passant = "-";
+  toggle_state_keys();
+  halfmove_clock++;
+  active_color = (active_color == "white" ? "black" : "white");
+  key ^= ZOBRIST.side;
+}
+
+void gameState::put_piece(int x, int y, char piece){
+  gameBoard[x][y] = piece;
+  int p = piece_index(piece);
+  listIndex[x*8 + y] = pieceCount[p];
+  pieceSquares[p][pieceCount[p]++] = uint8_t(x*8 + y);
+  key ^= ZOBRIST.piece[piece_index(piece)][x*8 + y];
+  if(piece == 'P' || piece == 'p'){
+    pawnKey ^= ZOBRIST.piece[piece_index(piece)][x*8 + y];
   }
-  if(check_space(gameBoard, color, x-2, y+1, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x-2, y+1);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x-2,y+1));
+}
+
+void gameState::remove_piece(int x, int y){
+  char piece = gameBoard[x][y];
+  key ^= ZOBRIST.piece[piece_index(piece)][x*8 + y];
+  if(piece == 'P' || piece == 'p'){
+    pawnKey ^= ZOBRIST.piece[piece_index(piece)][x*8 + y];
+  }
+  gameBoard[x][y] = '-';
+  //Fill the gap with the last piece of the list
+  int p = piece_index(piece);
+  int last = pieceSquares[p][--pieceCount[p]];
+  pieceSquares[p][listIndex[x*8 + y]] = uint8_t(last);
+  listIndex[last] = listIndex[x*8 + y];
+}
+
+//Print the current board datastructure
+void gameState::print_board(){
+  log_printf(LOG_INFO, "  a b c d e f g h");
+  for(int i = 0; i < 8; i++){
+    char row[17];
+    for (int j = 0; j < 8; j++){
+      row[2*j] = gameBoard[i][j];
+      row[2*j+1] = ' ';
     }
+    row[16] = '\0';
+    log_printf(LOG_INFO, "%d %s", 8-i, row);
   }
-  if(check_space(gameBoard, color, x-2, y-1, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x-2, y-1);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x-2,y-1));
-    }
+}
+
+void gameState::get_valid_moves(vector<string> & valid_moves, const string & color){
+  MoveList moves;
+  generate_moves(moves, color);
+  for(int k = 0; k < moves.count; k++){
+    valid_moves.push_back(move_to_uci(moves.moves[k]));
   }
-  if(check_space(gameBoard, color, x+1, y+2, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x+1, y+2);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x+1,y+2));
-    }
+}
+
+void gameState::generate_moves(MoveList & valid_moves, const string & color){
+  //If the castling string is not blank, generate moves indicated
+  if(castling != "-"){
+    get_castling_moves(valid_moves, color);
   }
-  if(check_space(gameBoard, color, x-1, y+2, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x-1, y+2);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x-1,y+2));
+  //If the en_passant string is not blank, generate moves indicated
+  if(en_passant != "-"){
+    get_en_passant_moves(valid_moves, color);
+  }
+  //For each of the color's pieces, from the piece lists
+  const char * pieces = (color == "white" ? "PNBRQK" : "pnbrqk");
+  for(int type = 0; type < 6; type++){
+    int p = piece_index(pieces[type]);
+    for(int k = 0; k < pieceCount[p]; k++){
+      int i = pieceSquares[p][k] / 8;
+      int j = pieceSquares[p][k] % 8;
+      //Generate all moves for appropriate piece
+      switch(type){
+        case 0:
+          get_pawn_moves(valid_moves, color, i, j);
+          break;
+        case 1:
+          get_knight_moves(valid_moves, color, i, j);
+          break;
+        case 2:
+          get_bishop_moves(valid_moves, color, i, j);
+          break;
+        case 3:
+          get_rook_moves(valid_moves, color, i, j);
+          break;
+        case 4:
+          get_queen_moves(valid_moves, color, i, j);
+          break;
+        case 5:
+          get_king_moves(valid_moves, color, i, j);
+          break;
+      }
     }
   }
-  if(check_space(gameBoard, color, x+1, y-2, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x+1, y-2);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx,  kingy)){
-      valid_moves.push_back(move_string(x,y,x+1,y-2));
+}
+
+void gameState::get_pawn_moves(MoveList & valid_moves, const string & color, int x, int y){
+  int dir = (color == "white" ? -1 : 1);        //White pawns move up the board, black pawns move down
+  int startRow = (color == "white" ? 6 : 1);    //Row the pawns start on, where they may move 2 spaces
+  char pawn = (color == "white" ? 'P' : 'p');
+
+  //Check if a single space forward is a valid move
+  if(x+dir >= 0 && x+dir < 8 && gameBoard[x+dir][y] == '-'){
+    add_pawn_move(valid_moves, color, pawn, x, y, x+dir, y);
+    //If the pawn has not moved yet, check if it is able to move 2 spaces
+    if(x == startRow && gameBoard[x+2*dir][y] == '-'){
+      add_pawn_move(valid_moves, color, pawn, x, y, x+2*dir, y);
     }
   }
-  if(check_space(gameBoard, color, x-1, y-2, pieceTaken)){
-    //copy the board and simulate the move
-    copyBoard(gameBoard, dupBoard, (color == "white" ? 'N' : 'n'), x, y, x-1, y-2);
-    getKingPos(dupBoard, color, kingx, kingy);
-    //if the king not in check, move is valid
-    if(!isKingCheck(dupBoard, color, kingx, kingy)){
-      valid_moves.push_back(move_string(x,y,x-1,y-2));
+  //If there is an enemy piece on a diagonal the pawn attacks, it can be taken
+  uint64_t targets = PAWN_ATTACKS.sq[color == "white" ? WHITE : BLACK][x*8 + y];
+  while(targets){
+    int s = pop_lsb(targets);
+    if(isEnemyPiece(gameBoard[s/8][s%8], color)){
+      add_pawn_move(valid_moves, color, pawn, x, y, s/8, s%8);
     }
   }
 }
 
-void gameState::get_bishop_moves(vector<string> & valid_moves, string color, int x, int y){
-  //Use for loop to look for valid moves in the four diagonal directions.
-  //If theres no valid move or a peice is taken, the piece can go no more in that direction.
-
-  bool peiceReplaced = false;  //indicates if a peice will be replaced by a move
-  char dupBoard[8][8];         //Space to copy  the board to simulate a move
-  int kingx;
-  int kingy;
-
-  //For every space in a direction
-  for(int i = 1; i < 9; i++){
-    //If the spot is a valid move
-    if(check_space(gameBoard, color, x+i, y+i, peiceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'B' : 'b'), x, y, x+i, y+i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is  valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+i,y+i));
-      }
-    //If the move is not valid, there will be no more valid moves in this direction.
-    } else break;
-    //When a peice is taken, there will be no more valid moves this direction
-    if(peiceReplaced) break;
+void gameState::add_pawn_move(MoveList & valid_moves, const string & color, char pawn, int startx, int starty, int x, int y){
+  //If king not in check after the move, move is valid
+  if(move_is_safe(color, pawn, startx, starty, x, y)){
+    //A pawn reaching the last row must be promoted, so add a move for each piece it can become
+    if(x == 0 || x == 7){
+      valid_moves.add(pack_move(startx, starty, x, y, PROMOTE_QUEEN));
+      valid_moves.add(pack_move(startx, starty, x, y, PROMOTE_ROOK));
+      valid_moves.add(pack_move(startx, starty, x, y, PROMOTE_BISHOP));
+      valid_moves.add(pack_move(startx, starty, x, y, PROMOTE_KNIGHT));
+    } else {
+      valid_moves.add(pack_move(startx, starty, x, y));
+    }
   }
-  peiceReplaced = false;
+}
 
-  //For every space in a direction
-  for(int i = 1; i < 9; i++){
-    //If the spot is a valid move
-    if(check_space(gameBoard, color, x-i, y-i, peiceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'B' : 'b'), x, y, x-i, y-i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is  valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-i,y-i));
-      }
-    //If the move is not valid, there will be no more valid moves in this direction.
-    } else break;
-    //When a peice is taken, there will be no more valid moves this direction
-    if(peiceReplaced) break;
+void gameState::get_knight_moves(MoveList & valid_moves, const string & color, int x, int y){
+  bool pieceTaken = false;  //indicates if move will take an enemy peice
+  //Check every space the knight attacks
+  uint64_t targets = KNIGHT_ATTACKS.sq[x*8 + y];
+  while(targets){
+    int s = pop_lsb(targets);
+    if(check_space(gameBoard, color, s/8, s%8, pieceTaken)){
+      add_if_legal(valid_moves, color, (color == "white" ? 'N' : 'n'), x, y, s/8, s%8);
+    }
   }
-  peiceReplaced = false;
+}
 
-  //For every space in a direction
-  for(int i = 1; i < 9; i++){
-    //If the spot is a valid move
-    if(check_space(gameBoard, color, x+i, y-i, peiceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'B' : 'b'), x, y, x+i, y-i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is  valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+i,y-i));
-      }
-    //If the move is not valid, there will be no more valid moves in this direction.
-    } else break;
-    //When a peice is taken, there will be no more valid moves this direction
-    if(peiceReplaced) break;
+void gameState::add_if_legal(MoveList & valid_moves, const string & color, char piece, int startx, int starty, int x, int y){
+  //If king not in check after the move, move is valid
+  if(move_is_safe(color, piece, startx, starty, x, y)){
+    valid_moves.add(pack_move(startx, starty, x, y));
   }
-  peiceReplaced = false;
+}
 
-  //For every space in a direction
-  for(int i = 1; i < 9; i++){
-    //If the spot is a valid move
-    if(check_space(gameBoard, color, x-i, y+i, peiceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'B' : 'b'), x, y, x-i, y+i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is  valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-i,y+i));
-      }
-    //If the move is not valid, there will be no more valid moves in this direction.
-    } else break;
-    //When a peice is taken, there will be no more valid moves this direction
-    if(peiceReplaced) break;
-  }
+bool gameState::move_is_safe(const string & color, char piece, int startx, int starty, int x, int y){
+  char dupBoard[8][8];  //space to duplicate the board and simulate a move
+  //The king is wherever it moves to, or else where it already stands
+  int king = ((piece == 'K' || piece == 'k') ? x*8 + y : king_square(color));
+  //Copy and simulate move
+  copyBoard(gameBoard, dupBoard, piece, startx, starty, x, y);
+  //A pawn moving diagonally onto a blank space takes the pawn beside it en passant
+  if((piece == 'P' || piece == 'p') && starty != y && gameBoard[x][y] == '-'){
+    dupBoard[startx][y] = '-';
+  }
+  return !isKingCheck(dupBoard, color, king/8, king%8);
 }
 
-void gameState::get_rook_moves(vector<string> & valid_moves, string color, int x, int y){
-  //Use for loop to look for valid moves in the four directions.
-  //If theres no valid move or a peice is taken, the piece can go no more in that direction.
+void gameState::get_bishop_moves(MoveList & valid_moves, const string & color, int x, int y){
+  add_slider_moves(valid_moves, color, (color == "white" ? 'B' : 'b'), x, y, true, false);
+}
 
-  bool pieceReplaced = false;  //Indicates whether a peice has been taken in that direction
-  char dupBoard[8][8];         //Space to copy the board to simulate  a move
-  int kingx;
-  int kingy;
+void gameState::get_rook_moves(MoveList & valid_moves, const string & color, int x, int y){
+  add_slider_moves(valid_moves, color, (color == "white" ? 'R' : 'r'), x, y, false, true);
+}
 
-  //For a direction, check moves
-  for(int i = 1; i < 9; i++){
-    //Check if space is available
-    if(check_space(gameBoard, color, x+i, y, pieceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'R' : 'r'), x, y, x+i, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+i,y));
-      }
-    //If the move isnt valid, there will be no more moves this direction
-    } else break;
-    //If a piece has been taken, then there will be no more valid moves in this direction
-    if(pieceReplaced) break;
-  }
-  pieceReplaced = false;
+void gameState::get_queen_moves(MoveList & valid_moves, const string & color, int x, int y){
+  add_slider_moves(valid_moves, color, (color == "white" ? 'Q' : 'q'), x, y, true, true);
+}
 
-  //For a direction, check moves
-  for(int i = 1; i < 9; i++){
-    //Check if space is available
-    if(check_space(gameBoard, color, x-i, y, pieceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'R' : 'r'), x, y, x-i, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-i,y));
-      }
-    //If the move isnt valid, there will be no more moves this direction
-    } else break;
-    //If a piece has been taken, then there will be no more valid moves in this direction
-    if(pieceReplaced) break;
+void gameState::add_slider_moves(MoveList & valid_moves, const string & color, char piece, int x, int y, bool diagonals, bool straights){
+  bool pieceTaken = false;  //indicates if move will take an enemy peice
+  //Every space the piece reaches, stopping at the first piece in each direction
+  uint64_t targets = sliding_attacks(gameBoard, x, y, diagonals, straights);
+  while(targets){
+    int s = pop_lsb(targets);
+    //The first piece in a direction can only be taken if it is an enemy
+    if(check_space(gameBoard, color, s/8, s%8, pieceTaken)){
+      add_if_legal(valid_moves, color, piece, x, y, s/8, s%8);
+    }
   }
-  pieceReplaced = false;
+}
 
-  //For a direction, check moves
-  for(int i = 1; i < 9; i++){
-    //Check if space is available
-    if(check_space(gameBoard, color, x, y+i, pieceReplaced)){
-      //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'R' : 'r'), x, y, x, y+i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x,y+i));
-      }
-    //If the move isnt valid, there will be no more moves this direction
-    } else break;
-    //If a piece has been taken, then there will be no more valid moves in this direction
-    if(pieceReplaced) break;
-  }
-  pieceReplaced = false;
+void gameState::get_king_moves(MoveList & valid_moves, const string & color, int x, int y){
+  //Check the moves around the king. If the move prevents check, it is valid
 
-  //For a direction, check moves
-  for(int i = 1; i < 9; i++){
-    //Check if space is available
-    if(check_space(gameBoard, color, x, y-i, pieceReplaced)){
+  bool pieceTaken = false; //Indicates whether peice has been taken
+  char dupBoard[8][8];     //space to duplicate board to check for check
+  //for the area around the current king
+  uint64_t targets = KING_ATTACKS.sq[x*8 + y];
+  while(targets){
+    int s = pop_lsb(targets);
+    //If the space is a valid space
+    if(check_space(gameBoard, color, s/8, s%8, pieceTaken)){
       //Copy the board and simulate the move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'R' : 'r'), x, y, x, y-i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x,y-i));
+      copyBoard(gameBoard, dupBoard, (color == "white" ? 'K' : 'k'), x, y, s/8, s%8);
+      if(!isKingCheck(dupBoard, color, s/8, s%8)){
+        valid_moves.add(pack_move(x,y,s/8,s%8));
       }
-    //If the move isnt valid, there will be no more moves this direction
-    } else break;
-    //If a piece has been taken, then there will be no more valid moves in this direction
-    if(pieceReplaced) break;
+    }
   }
 }
 
-void gameState::get_queen_moves(vector<string> & valid_moves, string color, int x, int y){
-  //Use for loop to look for valid moves in the eight directions.
-  //If theres no valid move or a peice is taken, the piece can go no more in that direction.
-
-  bool pieceReplaced = false;  //Indicates whether a piece has been taken
-  char dupBoard[8][8];         //space to copy the board to simulate a move
-  int kingx;
-  int kingy;
-
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x+i, y+i, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x+i, y+i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+i,y+i));
-      }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
+void gameState::get_castling_moves(MoveList & valid_moves, const string & color){
+  //Castling moves the king two spots towards the target rook,
+  // then moves the rook to the other side of the king.
+  int row = (color == "white" ? 7 : 0);
+  char king = (color == "white" ? 'K' : 'k');
+  char rook = (color == "white" ? 'R' : 'r');
+  bool kingside = castling.find(color == "white" ? 'K' : 'k') != string::npos;
+  bool queenside = castling.find(color == "white" ? 'Q' : 'q') != string::npos;
+
+  //The king must be home and not in check
+  if(gameBoard[row][4] != king || isKingCheck(gameBoard, color, row, 4)){
+    return;
+  }
+  //Kingside: the spaces to the rook are blank and the king does not pass through check
+  if(kingside && gameBoard[row][7] == rook && gameBoard[row][5] == '-' && gameBoard[row][6] == '-' &&
+     move_is_safe(color, king, row, 4, row, 5) && move_is_safe(color, king, row, 4, row, 6)){
+    valid_moves.add(pack_move(row, 4, row, 6));
+  }
+  //Queenside: the rook also passes the space next to it, which may be attacked
+  if(queenside && gameBoard[row][0] == rook && gameBoard[row][1] == '-' && gameBoard[row][2] == '-' &&
+     gameBoard[row][3] == '-' && move_is_safe(color, king, row, 4, row, 3) && move_is_safe(color, king, row, 4, row, 2)){
+    valid_moves.add(pack_move(row, 4, row, 2));
   }
-  pieceReplaced = false;
+}
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x-i, y-i, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x-i, y-i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-i,y-i));
+void gameState::get_en_passant_moves(MoveList & valid_moves, const string & color){
+  if(en_passant != "-"){
+    //get board position x,y from en_passant string
+    int x = '8' - en_passant[1];
+    int y = en_passant[0] - 'a';
+    char pawn = (color == "white" ? 'P' : 'p');
+    //The pawns that can take en passant are on the spaces an enemy pawn on the en passant space would attack
+    uint64_t attackers = PAWN_ATTACKS.sq[color == "white" ? BLACK : WHITE][x*8 + y];
+    while(attackers){
+      int s = pop_lsb(attackers);
+      //if there is a pawn, and taking does not leave the king in check, then it can perform move
+      if(gameBoard[s/8][s%8] == pawn){
+        add_if_legal(valid_moves, color, pawn, s/8, s%8, x, y);
       }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
+    }
   }
-  pieceReplaced = false;
+}
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x+i, y-i, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x+i, y-i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+i,y-i));
-      }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
-  }
-  pieceReplaced = false;
+bool gameState::in_check(){
+  int king = king_square(active_color);
+  return isKingCheck(gameBoard, active_color, king/8, king%8);
+}
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x-i, y+i, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x-i, y+i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-i,y+i));
-      }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
+//TRUE if every space in squares is blank, treating the space ignore as blank
+static bool path_clear(char gameBoard[][8], uint64_t squares, int ignore){
+  while(squares){
+    int s = pop_lsb(squares);
+    if(s != ignore && gameBoard[s/8][s%8] != '-'){
+      return false;
+    }
   }
-  pieceReplaced = false;
+  return true;
+}
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x+i, y, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x+i, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x+i,y));
-      }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
-  }
-  pieceReplaced = false;
+bool gameState::is_tactical(Move move){
+  int to = move_to(move);
+  int from = move_from(move);
+  char piece = gameBoard[from/8][from%8];
+  if(gameBoard[to/8][to%8] != '-' || move_promotion(move) != PROMOTE_NONE) return true;
+  //A pawn moving diagonally onto a blank space takes en passant
+  return (piece == 'P' || piece == 'p') && (from%8) != (to%8);
+}
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x-i, y, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x-i, y);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x-i,y));
-      }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
-  }
-  pieceReplaced = false;
+bool gameState::gives_check(const string move){
+  return gives_check(uci_to_move(move));
+}
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x, y+i, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x, y+i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x,y+i));
+bool gameState::gives_check(Move move){
+  //Unpack the move to board positions
+  int startx = move_from(move)/8;
+  int starty = move_from(move)%8;
+  int x = move_to(move)/8;
+  int y = move_to(move)%8;
+  char piece = gameBoard[startx][starty];
+  char type = char(tolower(piece));
+
+  //Castling, en passant and promotion move or remove a second piece, so play them out in full
+  if(move_promotion(move) != PROMOTE_NONE || (type == 'k' && (y - starty == 2 || starty - y == 2)) ||
+     (type == 'p' && starty != y && gameBoard[x][y] == '-')){
+    gameState next = *this;
+    next.apply_move(move);
+    return next.in_check();
+  }
+
+  string enemy = (active_color == "white" ? "black" : "white");
+  int king = king_square(enemy);
+  int kingx = king/8;
+  int kingy = king%8;
+  int from = startx*8 + starty;
+  int to = x*8 + y;
+  bool straight = (kingx == x || kingy == y);  //TRUE if the king shares a row or column with the landing space
+
+  //Direct check from the space the piece lands on
+  switch(type){
+    case 'p':
+      if(PAWN_ATTACKS.sq[active_color == "white" ? WHITE : BLACK][to] & square_bit(kingx, kingy)) return true;
+      break;
+    case 'n':
+      if(KNIGHT_ATTACKS.sq[to] & square_bit(kingx, kingy)) return true;
+      break;
+    case 'b':
+    case 'r':
+    case 'q':
+      if(LINE.sq[to][king] && (type == 'q' || (type == 'r') == straight) &&
+         path_clear(gameBoard, BETWEEN.sq[to][king], from)){
+        return true;
       }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
+      break;
   }
-  pieceReplaced = false;
 
-  //for a direction
-  for(int i = 1; i < 9; i++){
-    //if space is valid for a move
-    if(check_space(gameBoard, color, x, y-i, pieceReplaced)){
-      //Copy the  board and simulate a move
-      copyBoard(gameBoard, dupBoard, (color == "white" ? 'Q' : 'q'), x, y, x, y-i);
-      getKingPos(dupBoard, color, kingx, kingy);
-      //If the king is not in check, move is valid
-      if(!isKingCheck(dupBoard, color, kingx, kingy)){
-        valid_moves.push_back(move_string(x,y,x,y-i));
+  //Discovered check: the piece leaves a line between the king and one of our sliders
+  if(LINE.sq[from][king] && !(LINE.sq[from][king] & square_bit(x, y)) &&
+     path_clear(gameBoard, BETWEEN.sq[king][from], -1)){
+    bool diagonal = !(kingx == startx || kingy == starty);
+    int dx = (startx > kingx ? 1 : (startx < kingx ? -1 : 0));
+    int dy = (starty > kingy ? 1 : (starty < kingy ? -1 : 0));
+    //Walk past the moved piece, away from the king, to the first piece on the line
+    for(int i = startx + dx, j = starty + dy; i >= 0 && i < 8 && j >= 0 && j < 8; i += dx, j += dy){
+      char behind = gameBoard[i][j];
+      if(behind == '-') continue;
+      if(!isEnemyPiece(behind, active_color)){
+        char slider = char(tolower(behind));
+        return slider == 'q' || slider == (diagonal ? 'b' : 'r');
       }
-    //If the move isnt valid, there will not be another valid move in that direction
-    } else break;
-    //If a piece is taken, there will be no more valid moves that direction
-    if(pieceReplaced) break;
+      break;
+    }
   }
+  return false;
 }
 
-void gameState::get_king_moves(vector<string> & valid_moves, string color, int x, int y){
-  //Check the moves around the king. If the move prevents check, it is valid
-  
-  bool pieceTaken = false; //Indicates whether peice has been taken
-  char dupBoard[8][8];     //space to duplicate board to check for check
-  //for the area around the current king
-  for(int i = -1; i <= 1; i++){
-    for(int j = -1; j <= 1; j++){
-      if(i != 0 || j != 0){
-        //If the space is a valid space
-        if(check_space(gameBoard, color, x+i,y+j, pieceTaken)){
-          //Copy the board and simulate the move
-          copyBoard(gameBoard, dupBoard, (color == "white" ? 'K' : 'k'), x, y, x+i, y+j);
-          if(!isKingCheck(dupBoard, color, x+i, y+j)){
-            valid_moves.push_back(move_string(x,y,x+i,y+j));
-          }
-        }
-      }
+bool gameState::has_any_legal_move(){
+  const string & color = active_color;
+  bool pieceTaken = false;
+  int kingx = king_square(color)/8;
+  int kingy = king_square(color)%8;
+
+  //King moves are tried first, they are the most likely to be the only way out of check
+  uint64_t targets = KING_ATTACKS.sq[kingx*8 + kingy];
+  while(targets){
+    int s = pop_lsb(targets);
+    if(check_space(gameBoard, color, s/8, s%8, pieceTaken) &&
+       move_is_safe(color, gameBoard[kingx][kingy], kingx, kingy, s/8, s%8)){
+      return true;
     }
   }
-}
 
-void gameState::get_castling_moves(vector<string> & valid_moves){
-  char dupBoard[8][8];
-  //Castling moves the king two spots towards the target rook,
-  // then moves the rook to the other side of the king.
-  if(castling.find("K")){
-    //White to castle kingside
-    if(gameBoard[0][0] == 'R' &&
-       gameBoard[0][1] == '-' &&
-       gameBoard[0][2] == '-' &&
-       gameBoard[0][3] == '-' &&
-       gameBoard[0][4] == 'K'){
-         //copy board, move king
-         copyBoard(gameBoard, dupBoard, 'K', 0, 4, 0, 1);
-         //move rook
-         dupBoard[0][2] = 'R';
-         dupBoard[0][0] = '-';
-         //if not in check, valid
-         if(!isKingCheck(dupBoard, "white", 0, 1)){
-           valid_moves.push_back("e1c1");
-         }
-    }
-  }
-  if(castling.find("Q")){
-    //White can castle queenside
-    if(gameBoard[0][7] == 'R' &&
-       gameBoard[0][6] == '-' &&
-       gameBoard[0][5] == '-' &&
-       gameBoard[0][4] == 'K'){
-         //copy board, move king
-         copyBoard(gameBoard, dupBoard, 'K', 0, 4, 0, 5);
-         //move rook
-         dupBoard[0][7] ='-';
-         dupBoard[0][6] = 'R';
-         //if not in check, valid
-         if(!isKingCheck(dupBoard, "white", 0, 5)){
-           valid_moves.push_back("e1g1");
-         }
-    }
-    
-  }
-  if(castling.find("k")){
-    //Black can castle kingside
-    if(gameBoard[7][0] == 'r' &&
-       gameBoard[7][1] == '-' &&
-       gameBoard[7][2] == '-' &&
-       gameBoard[7][3] == '-' &&
-       gameBoard[7][4] == 'k'){
-         //copy board, move king
-         copyBoard(gameBoard, dupBoard, 'k', 7, 4, 7, 1);
-         //move rook
-         dupBoard[7][2] = 'r';
-         dupBoard[7][0] = '-';
-         //if not in check, valid
-         if(!isKingCheck(dupBoard, "black", 7, 1)){
-           valid_moves.push_back("e8c8");
-         }
-    }
-  }
-  if(castling.find("q")){
-    //Black can castle queenside
-    if(gameBoard[7][7] == 'r' &&
-       gameBoard[7][6] == '-' &&
-       gameBoard[7][5] == '-' &&
-       gameBoard[7][4] == 'k'){
-         //copy board, move king
-         copyBoard(gameBoard, dupBoard, 'k', 7, 4, 7, 5);
-         //move rook
-         dupBoard[7][7] ='-';
-         dupBoard[7][6] = 'r';
-         //if not in check, valid
-         if(!isKingCheck(dupBoard, "black", 7, 5)){
-           //Add move to list
-           valid_moves.push_back("e8g8");
-         }
-    }
-  }
-}
-
-void gameState::get_en_passant_moves(vector<string> & valid_moves, string color){
-  if(en_passant != "-"){
-    //get char position x,y from en_passant string
-    int x = char(en_passant[0]-'0')-'0';
-    int y = en_passant[0]-'0';
-    //if white
-    if(color == "white"){
-      //check that diagonal is valid
-      if(x+1 >= 0 && x+1 < 8){
-        //if there is a pawn, then it can perform move
-        if(gameBoard[x+1][y+1] == 'p'){
-          valid_moves.push_back(move_string(x+1, y+1, x, y));
-        }
-      }
-      //check if other diagonal is valid
-      if(x-1 >= 0 && x-1 < 8){
-        //if there is a pawn, then it can perform move
-        if(gameBoard[x-1][y+1] == 'p'){
-          valid_moves.push_back(move_string(x-1, y+1, x, y));
-        }
-      }
-    //If black
-    } else if(color == "black"){
-      //check that diagonal is valid
-      if(x+1 >= 0 && x+1 < 8){
-        //if there is a pawn, then it can perform move
-        if(gameBoard[x+1][y-1] == 'P'){
-          valid_moves.push_back(move_string(x+1, y-1, x, y));
+  //For each of the other pieces, collect the spaces it can reach and stop at the first safe one
+  const char * pieces = (color == "white" ? "PNBRQ" : "pnbrq");
+  for(int type = 0; type < 5; type++){
+    char piece = pieces[type];
+    int p = piece_index(piece);
+    for(int k = 0; k < pieceCount[p]; k++){
+      int i = pieceSquares[p][k] / 8;
+      int j = pieceSquares[p][k] % 8;
+      targets = 0;
+      switch(tolower(piece)){
+        case 'p': {
+          int dir = (color == "white" ? -1 : 1);
+          int startRow = (color == "white" ? 6 : 1);
+          if(i+dir >= 0 && i+dir < 8 && gameBoard[i+dir][j] == '-'){
+            targets |= square_bit(i+dir, j);
+            if(i == startRow && gameBoard[i+2*dir][j] == '-') targets |= square_bit(i+2*dir, j);
+          }
+          //Diagonals only count when there is an enemy to take
+          uint64_t captures = PAWN_ATTACKS.sq[color == "white" ? WHITE : BLACK][i*8 + j];
+          while(captures){
+            int s = pop_lsb(captures);
+            if(isEnemyPiece(gameBoard[s/8][s%8], color)) targets |= square_bit(s/8, s%8);
+          }
+          break;
         }
-      }
-      //check that diagonal is valid
-      if(x-1 >= 0 && x-1 < 8){
-        //if there is a pawn, then it can perform move
-        if(gameBoard[x-1][y-1] == 'P'){
-          valid_moves.push_back(move_string(x-1, y-1, x, y));
+        case 'n':
+          targets = KNIGHT_ATTACKS.sq[i*8 + j];
+          break;
+        case 'b':
+          targets = sliding_attacks(gameBoard, i, j, true, false);
+          break;
+        case 'r':
+          targets = sliding_attacks(gameBoard, i, j, false, true);
+          break;
+        case 'q':
+          targets = sliding_attacks(gameBoard, i, j, true, true);
+          break;
+      }
+      while(targets){
+        int s = pop_lsb(targets);
+        if(check_space(gameBoard, color, s/8, s%8, pieceTaken) && move_is_safe(color, piece, i, j, s/8, s%8)){
+          return true;
         }
       }
     }
   }
+
+  //En passant can be the only way out of check. Castling never is, since the king
+  //could also make the first step of it on its own
+  MoveList en_passant_moves;
+  get_en_passant_moves(en_passant_moves, color);
+  return en_passant_moves.count > 0;
 }
 
-bool check_space(char gameBoard[][8], string color, int x, int y, bool & pieceReplaced){
+bool check_space(char gameBoard[][8], const string & color, int x, int y, bool & pieceReplaced){
   //If the space is on the game board
   if((x < 8 && y < 8) && (x >= 0 && y >= 0)){
     //if the space is blank
@@ -784,7 +617,7 @@ string move_string(int startx, int starty, int x, int y){
   return m_string;
 }
 
-bool isEnemyPiece(char piece, string color){
+bool isEnemyPiece(char piece, const string & color){
   if(color == "white"){
     if(piece == 'p' ||
        piece == 'r' ||
@@ -810,17 +643,16 @@ bool isEnemyPiece(char piece, string color){
   return false;
 }
 
-bool isKingCheck(char gameBoard[][8], string color, int x, int y){
-  //Manually check if there is a knight in 8 spaces that could put king in check
-  if(gameBoard[x+2][y+1] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x+2][y-1] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x-2][y+1] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x-2][y-1] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x+1][y+2] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x-1][y+2] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x+1][y-2] == (color == "black" ? 'N' : 'n') ||
-     gameBoard[x-1][y-2] == (color == "black" ? 'N' : 'n')){
-       return true;
+bool isKingCheck(char gameBoard[][8], const string & color, int x, int y){
+  int kingSq = x*8 + y;
+  char knight = (color == "black" ? 'N' : 'n');
+  //Check every space a knight could put the king in check from
+  uint64_t attackers = KNIGHT_ATTACKS.sq[kingSq];
+  while(attackers){
+    int s = pop_lsb(attackers);
+    if(gameBoard[s/8][s%8] == knight){
+      return true;
+    }
   }
   //check all directions radially for a piece to put king in check.
   //Diagonal axises check for queen, king, and bishop
@@ -903,26 +735,23 @@ bool isKingCheck(char gameBoard[][8], string color, int x, int y){
   }
 
   //Check if a king is putting you in check
-  for(int i = -1; i <= 1; i++){
-    for(int j = -1; j <= 1; j++){
-      if(gameBoard[x+i][y+j] == (color == "black" ? 'K' : 'k')){
-        return true;
-      }
+  char king = (color == "black" ? 'K' : 'k');
+  attackers = KING_ATTACKS.sq[kingSq];
+  while(attackers){
+    int s = pop_lsb(attackers);
+    if(gameBoard[s/8][s%8] == king){
+      return true;
     }
   }
 
-  //Check if pawns are putting the king in check
-  if(color == "white"){
-    if((x-1 < 8 && x-1 >= 0) && ((y+1 < 8 && y+1 >= 0) || (y-1 < 8 && y-1 >= 0))){
-      if(gameBoard[x-1][y+1] == 'p' || gameBoard[x-1][y-1] == 'p'){
-        return true;
-      }
-    }
-  }else if(color == "black"){
-    if((x+1 < 8 && x+1 >= 0) && ((y+1 < 8 && y+1 >= 0) || (y-1 < 8 && y-1 >= 0))){
-      if(gameBoard[x+1][y+1] == 'P' || gameBoard[x+1][y-1] == 'P'){
-        return true;
-      }
+  //Check if pawns are putting the king in check. An enemy pawn attacks the king from
+  //the same spaces a friendly pawn on the king's space would attack
+  char pawn = (color == "black" ? 'P' : 'p');
+  attackers = PAWN_ATTACKS.sq[color == "black" ? BLACK : WHITE][kingSq];
+  while(attackers){
+    int s = pop_lsb(attackers);
+    if(gameBoard[s/8][s%8] == pawn){
+      return true;
     }
   }
   return false;
@@ -942,7 +771,24 @@ void copyBoard(char gameBoard[][8], char copyBoard[][8], char character, int sta
   }
 }
 
-void getKingPos(char gameBoard[][8], string color, int & kingx, int & kingy){
+uint64_t sliding_attacks(char gameBoard[][8], int x, int y, bool diagonals, bool straights){
+  uint64_t attacks = 0;
+  for(int dx = -1; dx <= 1; dx++){
+    for(int dy = -1; dy <= 1; dy++){
+      if(dx == 0 && dy == 0) continue;
+      bool diagonal = (dx != 0 && dy != 0);
+      if((diagonal && !diagonals) || (!diagonal && !straights)) continue;
+      //Walk the direction until the edge of the board or the first piece
+      for(int i = x+dx, j = y+dy; i >= 0 && i < 8 && j >= 0 && j < 8; i += dx, j += dy){
+        attacks |= square_bit(i, j);
+        if(gameBoard[i][j] != '-') break;
+      }
+    }
+  }
+  return attacks;
+}
+
+void getKingPos(char gameBoard[][8], const string & color, int & kingx, int & kingy){
   for(int i = 0; i < 8; i++){
     for(int j = 0; j < 8; j++){
       if(gameBoard[i][j] == 'K' && color == "white"){
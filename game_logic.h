@@ -4,12 +4,18 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include "attack_tables.h"
+#include "zobrist.h"
+#include "move.h"
 using namespace std;
 
+const string STARTING_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+const int MAX_PIECES_OF_TYPE = 10;  //Two of a piece plus all eight pawns promoted to it
+
 //PRE : gameBoard must be filled in with letters or dashes '-'
 //POST: will return a boolean TRUE if the space is a valid move, FALSE if not
 //DESC: Checks to see if a space can be moved to. It must be either a blank space or an enemy piece
-bool check_space(char gameBoard[][8], string color, int x, int y, bool & pieceReplaced);
+bool check_space(char gameBoard[][8], const string & color, int x, int y, bool & pieceReplaced);
 
 //PRE : startx, starty, x, y must be between 0 and 7 (valid board space)
 //POST: returns a string for a move in UCI notation
@@ -19,12 +25,12 @@ string move_string(int startx, int starty, int x, int y);
 //PRE : None
 //POST: TRUE if an enemy, FALSE if same team or '-'
 //DESC: Returns a bool if the given piece is an enemy of the given color
-bool isEnemyPiece(char piece, string color);
+bool isEnemyPiece(char piece, const string & color);
 
 //PRE : Gameboard must be filled in with pieces or '-'
 //POST: return TRUE if king is in check, FALSE if king is not in check
 //DESC: Takes an (x,y) of the king position, returns whether or not the king is in check.
-bool isKingCheck(char gameBoard[][8], string color, int x, int y);
+bool isKingCheck(char gameBoard[][8], const string & color, int x, int y);
 
 //PRE : gameBoard must be a valid chess board, x,y must be valid chess board positions
 //POST: copyBoard will be filled in with the peice already moved
@@ -32,10 +38,15 @@ bool isKingCheck(char gameBoard[][8], string color, int x, int y);
 //      to position (x,y)
 void copyBoard(char gameBoard[][8], char copyBoard[][8], char character, int startx, int starty, int x, int y);
 
+//PRE : gameBoard must be filled in with letters or dashes '-', x,y must be on the board
+//POST: returns the set of spaces a slider on (x,y) reaches, up to and including the first piece in each direction
+//DESC: Walk the diagonals if diagonals is TRUE and the rows and columns if straights is TRUE
+uint64_t sliding_attacks(char gameBoard[][8], int x, int y, bool diagonals, bool straights);
+
 //PRE : Board must be populated correctly
 //POST: King's x,y will be returned to the  kingx,kingy
 //DESC: Find the king on the board
-void getKingPos(char gameBoard[][8], string color, int & kingx, int & kingy);
+void getKingPos(char gameBoard[][8], const string & color, int & kingx, int & kingy);
 
 class gameState{
   public:
@@ -43,6 +54,14 @@ class gameState{
     bool isFirstMove;     //TRUE if is the first move, FALSE if else
     string castling;      //The string in the castling position of the fen string
     string en_passant;    //The string in the en passant positon of the fen string
+    string active_color;  //"white" or "black", the color whose turn it is
+    int halfmove_clock;   //Moves by either color since the last capture or pawn move, for the fifty move rule
+    int fullmove_number;  //Starts at 1 and goes up after each black move
+    uint64_t key;         //Zobrist key of the whole position, kept up to date by apply_move
+    uint64_t pawnKey;     //Zobrist key of only the pawns on the board, kept up to date by apply_move
+    uint8_t pieceSquares[12][MAX_PIECES_OF_TYPE];  //Spaces (x*8+y) of each piece type in no order, see piece_index
+    uint8_t pieceCount[12];                        //Number of each piece type on the board
+    uint8_t listIndex[64];                         //Where the piece on each space is in its pieceSquares list
 
     //PRE : FEN string must be in fen notation
     //POST: gameState's board will be populated
@@ -50,55 +69,150 @@ class gameState{
     void populate_board(const string fen);
 
     //PRE : None
-    //POST: Board is printed to the console
-    //DESC: Board is printed to the console
+    //POST: Board is written to the log
+    //DESC: Board is printed to the console through the log, see logger.h
     void print_board();
 
+    //PRE : Board must be populated correctly, color must be "black" or "white"
+    //POST: valid_moves holds all the valid moves of the color's board pieces
+    //DESC: Finds all the color's valid possible moves without allocating, used by the search
+    void generate_moves(MoveList & valid_moves, const string & color);
+
     //PRE : Board must be populated correctly, color must be "black" or "white"
     //POST: Populate valid_moves with all the valid moves of the color's board pieces
-    //DESC: Finds all the color's valid possible moves
-    void get_valid_moves(vector<string> & valid_moves, string color, char gameBoard[][8]);
+    //DESC: Finds all the color's valid possible moves in UCI notation
+    void get_valid_moves(vector<string> & valid_moves, const string & color);
+
+    //PRE : move must be a valid move for the current board
+    //POST: the board, castling, en_passant, move counters and keys will be updated to the position after the move
+    //DESC: Play a move on the board. Handles captures, en passant, castling and promotion
+    void apply_move(Move move);
+
+    //PRE : move must be a valid move in UCI notation for the current board
+    //POST: same as apply_move(Move)
+    //DESC: Play a move given in UCI notation
+    void apply_move(const string move);
+
+    //PRE : active_color must not be in check
+    //POST: active_color is switched, en passant is cleared and the keys are updated
+    //DESC: Pass the turn without moving, used by null move pruning in the search
+    void apply_null_move();
+
+    //PRE : Board must be populated correctly
+    //POST: returns TRUE if the king of the color to move is in check
+    //DESC: Checks the king of active_color without generating any moves
+    bool in_check();
+
+    //PRE : move must be a valid move for active_color in UCI notation
+    //POST: returns TRUE if the move puts the other color's king in check
+    //DESC: Looks for direct and discovered checks from the move without playing it on a copy of the board.
+    //      Castling, en passant and promotion are simulated since they change more than one space
+    bool gives_check(Move move);
+    bool gives_check(const string move);
+
+    //PRE : move must be a valid move for active_color
+    //POST: returns TRUE if the move takes a piece, including en passant, or promotes a pawn
+    bool is_tactical(Move move);
+
+    //PRE : Board must be populated correctly
+    //POST: returns TRUE if active_color has at least one valid move
+    //DESC: Stops at the first valid move it finds. With in_check this tells checkmate and stalemate apart
+    //      without building the whole move list
+    bool has_any_legal_move();
+
+    //PRE : gameBoard must be set
+    //POST: the piece lists are built from scratch
+    //DESC: Index the pieces on the board. apply_move keeps the lists up to date after this, so code that
+    //      fills in gameBoard itself must call this before generating moves
+    void index_pieces();
+
+    //PRE : the piece lists must be up to date
+    //POST: returns the space (x*8+y) of color's king
+    //DESC: Read from the piece lists instead of searching the board
+    int king_square(const string & color);
+
+    //PRE : board, castling, en_passant and active_color must be set
+    //POST: key and pawnKey are computed from scratch
+    //DESC: Hash the position. apply_move keeps the keys up to date after this
+    void compute_keys();
 
   private:
+    friend class MoveGenBenchmark;  //tools/microbench.cpp times the generators one piece type at a time
+
+    //PRE : castling and en_passant must be set
+    //POST: the castling and en passant keys are XORed in or out of key
+    //DESC: Called before and after a move changes castling or en_passant
+    void toggle_state_keys();
+
+    //PRE : (x,y) must be on the board and blank
+    //POST: piece is on (x,y) and the keys and piece lists include it
+    //DESC: Place a piece, updating the keys and piece lists incrementally
+    void put_piece(int x, int y, char piece);
+
+    //PRE : (x,y) must be on the board
+    //POST: (x,y) is blank and the keys and piece lists no longer include what was there
+    //DESC: Remove a piece, updating the keys incrementally. The last piece of the same type takes its place in the list
+    void remove_piece(int x, int y);
+
     //PRE : gameBoard must be populated correctly, x,y must be on the game board
     //POST: valid pawn moves from x,y will be added to valid_moves
     //DESC: Generate pawn moves from position x,y
-    void get_pawn_moves(vector<string> & valid_moves, string color, int x, int y);
+    void get_pawn_moves(MoveList & valid_moves, const string & color, int x, int y);
+
+    //PRE : gameBoard must be populated correctly, both positions must be on the game board
+    //POST: the move, or all four promotions if it reaches the last row, will be added to valid_moves if legal
+    //DESC: Pawn version of add_if_legal
+    void add_pawn_move(MoveList & valid_moves, const string & color, char pawn, int startx, int starty, int x, int y);
 
     //PRE : gameBoard must be populated correctly, x,y must be on the game board
     //POST: valid knight moves from x,y will be added to valid_moves
     //DESC: Generate knight moves from position x,y
-    void get_knight_moves(vector<string> & valid_moves, string color, int x, int y);
+    void get_knight_moves(MoveList & valid_moves, const string & color, int x, int y);
+
+    //PRE : gameBoard must be populated correctly, both positions must be on the game board
+    //POST: the move will be added to valid_moves if it does not leave the king in check
+    //DESC: Simulate moving piece from (startx,starty) to (x,y) and keep the move if it is legal
+    void add_if_legal(MoveList & valid_moves, const string & color, char piece, int startx, int starty, int x, int y);
+
+    //PRE : gameBoard must be populated correctly, both positions must be on the game board
+    //POST: returns TRUE if moving piece from (startx,starty) to (x,y) does not leave color's king in check
+    //DESC: Simulate the move on a copy of the board, including the pawn taken by an en passant move
+    bool move_is_safe(const string & color, char piece, int startx, int starty, int x, int y);
 
     //PRE : gameBoard must be populated correctly, x,y must be on the game board
     //POST: valid bishop moves from x,y will be added to valid_moves
     //DESC: Generate bishop moves from position x,y
-    void get_bishop_moves(vector<string> & valid_moves, string color, int x, int y);
+    void get_bishop_moves(MoveList & valid_moves, const string & color, int x, int y);
 
     //PRE : gameBoard must be populated correctly, x,y must be on the game board
     //POST: valid rook moves from x,y will be added to valid_moves
     //DESC: Generate rook moves from position x,y
-    void get_rook_moves(vector<string> & valid_moves, string color, int x, int y);
+    void get_rook_moves(MoveList & valid_moves, const string & color, int x, int y);
 
     //PRE : gameBoard must be populated correctly, x,y must be on the game board
     //POST: valid queen moves from x,y will be added to valid_moves
     //DESC: Generate queen moves from position x,y
-    void get_queen_moves(vector<string> & valid_moves, string color, int x, int y);
+    void get_queen_moves(MoveList & valid_moves, const string & color, int x, int y);
+
+    //PRE : gameBoard must be populated correctly, x,y must be on the game board
+    //POST: valid moves along the diagonals and/or rows and columns from x,y will be added to valid_moves
+    //DESC: Shared by the bishop, rook and queen generators
+    void add_slider_moves(MoveList & valid_moves, const string & color, char piece, int x, int y, bool diagonals, bool straights);
 
     //PRE : gameBoard must be populated correctly, x,y must be on the game board
     //POST: valid king moves from x,y will be added to valid_moves
     //DESC: Generate king moves from position x,y
-    void get_king_moves(vector<string> & valid_moves, string color, int x, int y);
+    void get_king_moves(MoveList & valid_moves, const string & color, int x, int y);
 
     //PRE : gameBoard must be populated correctly, castling string must be set
-    //POST: valid castling moves will be added to valid_moves
-    //DESC: Generate castling moves from castling string
-    void get_castling_moves(vector<string> & valid_moves);
+    //POST: valid castling moves for color will be added to valid_moves
+    //DESC: Generate castling moves from castling string. The king may not castle out of, through or into check
+    void get_castling_moves(MoveList & valid_moves, const string & color);
 
     //PRE : gameBoard must be populated correctly, en_passant string must be set
     //POST: valid en passant moves will be added to valid_moves
     //DESC: Generate en passant moves from en_passant string
-    void get_en_passant_moves(vector<string> & valid_moves, string color);
+    void get_en_passant_moves(MoveList & valid_moves, const string & color);
 };
 
 #endif
\ No newline at end of file
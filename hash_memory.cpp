@@ -0,0 +1,103 @@
+#include "hash_memory.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+using namespace std;
+
+//Zero bytes at start, splitting the work into huge page sized pieces over the machine's threads.
+//The first write to a page is what makes the kernel back it, so this is also the page touch
+static void parallel_zero(char * start, size_t bytes){
+  size_t pages = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE;
+  size_t threadCount = min<size_t>(max(1u, thread::hardware_concurrency()), pages);
+  if(threadCount <= 1){
+    memset(start, 0, bytes);
+    return;
+  }
+  vector<thread> threads;
+  size_t perThread = (pages + threadCount - 1) / threadCount * HUGE_PAGE_SIZE;
+  for(size_t t = 0; t < threadCount; t++){
+    size_t begin = t * perThread;
+    if(begin >= bytes) break;
+    size_t length = min(perThread, bytes - begin);
+    threads.push_back(thread([=](){ memset(start + begin, 0, length); }));
+  }
+  for(size_t t = 0; t < threads.size(); t++){
+    threads[t].join();
+  }
+}
+
+HashMemory::HashMemory(){
+  data = NULL;
+  bytes = 0;
+  hugePages = false;
+  mapping = NULL;
+  mappedBytes = 0;
+  mapped = false;
+}
+
+HashMemory::~HashMemory(){
+  release();
+}
+
+void HashMemory::allocate(size_t size){
+  release();
+#ifdef __linux__
+  //Map one huge page extra so the block can start on a huge page boundary, then give back the ends
+  size_t rounded = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  void * raw = mmap(NULL, rounded + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(raw != MAP_FAILED){
+    uintptr_t start = (reinterpret_cast<uintptr_t>(raw) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    size_t head = start - reinterpret_cast<uintptr_t>(raw);
+    size_t tail = HUGE_PAGE_SIZE - head;
+    if(head > 0) munmap(raw, head);
+    if(tail > 0) munmap(reinterpret_cast<char *>(start) + rounded, tail);
+    mapping = reinterpret_cast<void *>(start);
+    mappedBytes = rounded;
+    mapped = true;
+    hugePages = (madvise(mapping, rounded, MADV_HUGEPAGE) == 0);
+    data = mapping;
+  }
+#endif
+  if(data == NULL){
+    //Normal pages, aligned by hand to a cache line so table buckets never straddle two lines
+    mappedBytes = size + 64;
+    mapping = new (nothrow) char[mappedBytes];
+    if(mapping == NULL){
+      mappedBytes = 0;
+      return;
+    }
+    mapped = false;
+    data = reinterpret_cast<void *>((reinterpret_cast<uintptr_t>(mapping) + 63) / 64 * 64);
+  }
+  bytes = size;
+  clear();
+}
+
+void HashMemory::release(){
+#ifdef __linux__
+  if(mapping != NULL && mapped){
+    munmap(mapping, mappedBytes);
+  }
+#endif
+  if(mapping != NULL && !mapped){
+    delete[] static_cast<char *>(mapping);
+  }
+  data = NULL;
+  bytes = 0;
+  hugePages = false;
+  mapping = NULL;
+  mappedBytes = 0;
+  mapped = false;
+}
+
+void HashMemory::clear(){
+  if(data != NULL){
+    parallel_zero(static_cast<char *>(data), bytes);
+  }
+}
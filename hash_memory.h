@@ -0,0 +1,44 @@
+#ifndef HASH_MEMORY_H
+#define HASH_MEMORY_H
+#include <cstddef>
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;  //Size of a transparent huge page on x86-64 Linux
+
+//Memory for a large hash table. On Linux the block is mapped on a huge page boundary and marked with
+//madvise so the kernel backs it with 2 MB pages, cutting the TLB misses of random table lookups.
+//Anywhere else, or if mapping fails, it falls back to normal pages from new.
+//The pages are touched by several threads at once when allocated, so startup does not wait on one core.
+class HashMemory{
+  public:
+    void * data;      //Start of the block, aligned to at least 64 bytes. NULL if nothing is allocated
+    size_t bytes;     //Usable size of the block
+    bool hugePages;   //TRUE if the kernel accepted the huge page advice
+
+    HashMemory();
+    ~HashMemory();
+
+    //PRE : bytes must be at least 1
+    //POST: any earlier block is released, data points to bytes of zeroed memory, or is NULL if out of memory
+    //DESC: Allocate and touch a block for a hash table
+    void allocate(size_t bytes);
+
+    //PRE : None
+    //POST: the block is released and data is NULL
+    //DESC: Give the memory back
+    void release();
+
+    //PRE : None
+    //POST: every byte of the block is zero
+    //DESC: Zero the block, split across threads
+    void clear();
+
+  private:
+    void * mapping;     //What was mapped or allocated, which may start before data
+    size_t mappedBytes; //Size of mapping
+    bool mapped;        //TRUE if mapping came from mmap, FALSE if from new
+
+    HashMemory(const HashMemory &);
+    HashMemory & operator=(const HashMemory &);
+};
+
+#endif
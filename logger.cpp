@@ -0,0 +1,206 @@
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+//Longest the writer thread sleeps. Producers wake it without taking its lock, so a wakeup can be lost in the
+//moment between its last look and falling asleep, and this bounds how long such a line waits
+const int LOG_IDLE_WAKE_MS = 100;
+
+struct LogLine {
+  uint16_t length;
+  uint8_t level;
+  uint8_t unused;
+  char text[LOG_LINE_BYTES];
+};
+
+//Single producer, single consumer queue. Only the owning thread moves head and only the writer thread moves
+//tail, so neither needs a lock. Allocated on a cache line boundary so head and tail really are on lines of their own
+struct LogRing {
+  LogLine lines[LOG_RING_LINES];
+  alignas(64) atomic<uint32_t> head;   //Next line the owner writes
+  alignas(64) atomic<uint32_t> tail;   //Next line the writer thread reads
+  atomic<bool> owned;                  //A thread is logging into this ring. Rings of finished threads are reused
+};
+
+//Everything shared between the logging threads and the writer thread
+class Logger{
+  public:
+    atomic<int> level;
+    atomic<long> dropped;
+
+    Logger(){
+      level = LOG_INFO;
+      dropped = 0;
+      out = stdout;
+      running = false;
+      stopping = false;
+      pending = false;
+    }
+
+    ~Logger(){
+      {
+        lock_guard<mutex> guard(wakeLock);
+        stopping = true;
+      }
+      wake.notify_one();
+      if(writer.joinable()) writer.join();
+      drain();
+      lock_guard<mutex> guard(ringLock);
+      for(size_t k = 0; k < rings.size(); k++){
+        rings[k]->~LogRing();
+        free(rings[k]);
+      }
+      if(out != stdout) fclose(out);
+    }
+
+    //PRE : None
+    //POST: returns a ring no other thread is logging into, starting the writer thread the first time
+    LogRing * take_ring(){
+      lock_guard<mutex> guard(ringLock);
+      if(!running){
+        running = true;
+        writer = thread(&Logger::write_loop, this);
+      }
+      for(size_t k = 0; k < rings.size(); k++){
+        bool expected = false;
+        if(rings[k]->owned.compare_exchange_strong(expected, true)) return rings[k];
+      }
+      //new only aligns to 16 bytes before C++17, so the ring is placed in memory aligned by hand
+      void * memory = NULL;
+      if(posix_memalign(&memory, alignof(LogRing), sizeof(LogRing)) != 0) throw bad_alloc();
+      LogRing * ring = new (memory) LogRing();
+      ring->head = 0;
+      ring->tail = 0;
+      ring->owned = true;
+      rings.push_back(ring);
+      return ring;
+    }
+
+    //PRE : a line must have just been queued
+    //POST: the writer thread is woken if it is asleep
+    //DESC: Takes no lock, and only makes a system call for the first line since the writer last looked
+    void wake_writer(){
+      if(!pending.load(memory_order_relaxed) && !pending.exchange(true)) wake.notify_one();
+    }
+
+    //PRE : None
+    //POST: returns FALSE if path could not be opened
+    bool open(const string & path){
+      FILE * file = stdout;
+      if(!path.empty()){
+        file = fopen(path.c_str(), "a");
+        if(file == NULL) return false;
+      }
+      drain();
+      lock_guard<mutex> guard(outLock);
+      if(out != stdout) fclose(out);
+      out = file;
+      return true;
+    }
+
+    //PRE : None
+    //POST: every line queued so far is written and flushed. returns TRUE if there were any
+    //DESC: Run by the writer thread, and by log_flush and shutdown
+    bool drain(){
+      lock_guard<mutex> guardOut(outLock);
+      lock_guard<mutex> guardRings(ringLock);
+      bool wrote = false;
+      for(size_t k = 0; k < rings.size(); k++){
+        LogRing * ring = rings[k];
+        uint32_t tail = ring->tail.load(memory_order_relaxed);
+        uint32_t head = ring->head.load(memory_order_acquire);
+        for(; tail != head; tail++){
+          LogLine & line = ring->lines[tail % LOG_RING_LINES];
+          fwrite(line.text, 1, line.length, out);
+          wrote = true;
+        }
+        ring->tail.store(tail, memory_order_release);
+      }
+      if(wrote) fflush(out);
+      return wrote;
+    }
+
+  private:
+    mutex ringLock;           //Guards rings. Taken once per thread to get a ring, and by the writer
+    mutex outLock;            //Guards out, so draining from log_flush and the writer thread do not mix lines
+    vector<LogRing *> rings;
+    FILE * out;
+    thread writer;
+    bool running;             //TRUE once the writer thread is started
+    atomic<bool> stopping;
+    atomic<bool> pending;     //Set by producers when a line is queued, cleared by the writer before it drains
+    mutex wakeLock;           //Only for wake, producers never take it
+    condition_variable wake;  //Signalled when pending is set or the logger is stopping
+
+    //PRE : None
+    //POST: rings are drained until the logger is destroyed
+    //DESC: Sleeps on wake while there is nothing to write, so an idle log costs nothing
+    void write_loop(){
+      while(!stopping){
+        pending = false;
+        if(drain()) continue;
+        unique_lock<mutex> guard(wakeLock);
+        wake.wait_for(guard, chrono::milliseconds(LOG_IDLE_WAKE_MS), [this](){ return pending || stopping; });
+      }
+    }
+};
+
+static Logger logger;
+
+//Gives the thread's ring back when the thread finishes, so threads that come and go do not pile up rings
+struct RingOwner {
+  LogRing * ring = NULL;
+  ~RingOwner(){
+    if(ring != NULL) ring->owned.store(false, memory_order_release);
+  }
+};
+
+static thread_local RingOwner threadRing;
+
+bool log_open(const string & path, LogLevel level){
+  logger.level = level;
+  return logger.open(path);
+}
+
+bool log_enabled(LogLevel level){
+  return level <= logger.level.load(memory_order_relaxed);
+}
+
+void log_printf(LogLevel level, const char * format, ...){
+  if(!log_enabled(level)) return;
+  if(threadRing.ring == NULL) threadRing.ring = logger.take_ring();
+  LogRing * ring = threadRing.ring;
+  uint32_t head = ring->head.load(memory_order_relaxed);
+  if(head - ring->tail.load(memory_order_acquire) >= uint32_t(LOG_RING_LINES)){
+    logger.dropped++;
+    return;
+  }
+  LogLine & line = ring->lines[head % LOG_RING_LINES];
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(line.text, LOG_LINE_BYTES - 1, format, arguments);
+  va_end(arguments);
+  length = max(0, min(length, LOG_LINE_BYTES - 2));
+  line.text[length++] = '\n';
+  line.length = uint16_t(length);
+  line.level = uint8_t(level);
+  ring->head.store(head + 1, memory_order_release);
+  logger.wake_writer();
+}
+
+void log_flush(){
+  logger.drain();
+}
+
+long log_dropped(){
+  return logger.dropped;
+}
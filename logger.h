@@ -0,0 +1,47 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+#include <cstdint>
+#include <string>
+using namespace std;
+
+//Asynchronous logging. log_printf formats the line into a ring buffer owned by the calling thread and returns;
+//a background thread drains every ring to stdout or a file. The calling thread never waits on a lock or on the
+//output, so verbose search output can stay on even when stdout is a slow pipe. If a ring is full the line is
+//dropped and counted, since stalling the search would be worse than losing a line.
+
+enum LogLevel {
+  LOG_ERROR,
+  LOG_WARNING,
+  LOG_INFO,     //Default: what the engine has always printed, the board, iterations and move summaries
+  LOG_DEBUG
+};
+
+const int LOG_LINE_BYTES = 508;   //Longest line, longer ones are cut off
+const int LOG_RING_LINES = 512;   //Lines each thread can have waiting to be written
+
+//PRE : None
+//POST: lines at or above the importance of level are written to path, or to stdout if path is empty.
+//      returns FALSE if path cannot be opened, in which case stdout is kept
+//DESC: Optional, the log writes INFO and more important lines to stdout until this is called
+bool log_open(const string & path, LogLevel level);
+
+//PRE : None
+//POST: returns TRUE if lines at level are being written
+//DESC: Check before building an expensive line
+bool log_enabled(LogLevel level);
+
+//PRE : format must be a printf format matching the arguments
+//POST: the line is queued for the writer thread, or dropped if this thread's ring is full
+//DESC: Never blocks and never allocates after the thread's first line. A newline is added
+void log_printf(LogLevel level, const char * format, ...) __attribute__((format(printf, 2, 3)));
+
+//PRE : None
+//POST: every line logged before the call has been written and flushed
+//DESC: Call before the program exits or before writing to the same output directly
+void log_flush();
+
+//PRE : None
+//POST: returns the number of lines dropped because a ring was full
+long log_dropped();
+
+#endif
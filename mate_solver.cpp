@@ -0,0 +1,248 @@
+#include "mate_solver.h"
+#include <algorithm>
+#include "memory_accounting.h"
+
+const uint64_t MATE_DEPTH_SEED = 4051977;
+
+MateSolver::MateSolver(int hashMB){
+  uint64_t count = 1;
+  while(count * 2 * sizeof(MateEntry) <= uint64_t(hashMB) * 1024 * 1024){
+    count *= 2;
+  }
+  memory.allocate(count * sizeof(MateEntry));
+  //Out of memory, fall back to a couple of entries so the solver still works
+  if(memory.data == NULL){
+    count = 2;
+    memory.allocate(count * sizeof(MateEntry));
+  }
+  memory_charge(MEMORY_MATE_SOLVER, memory.bytes);
+  entries = static_cast<MateEntry *>(memory.data);
+  mask = count - 1;
+  for(int p = 0; p <= MAX_PLY; p++){
+    depthKeys[p] = splitmix64(MATE_DEPTH_SEED + p);
+  }
+  checksOnly = false;
+  nodeLimit = 0;
+  nodes = 0;
+  lineLength = 0;
+  stopped = false;
+}
+
+MateSolver::~MateSolver(){
+  memory_charge(MEMORY_MATE_SOLVER, -(long long)memory.bytes);
+}
+
+void MateSolver::clear(){
+  memory.clear();
+}
+
+MateEntry * MateSolver::probe(uint64_t key, int plies){
+  key ^= depthKeys[plies];
+  //Each key can be in one of two neighboring entries
+  MateEntry * slot = &entries[key & mask & ~uint64_t(1)];
+  if(slot[0].key == key) return &slot[0];
+  if(slot[1].key == key) return &slot[1];
+  return NULL;
+}
+
+void MateSolver::store(uint64_t key, int plies, uint32_t phi, uint32_t delta, int distance, long work){
+  key ^= depthKeys[plies];
+  MateEntry * slot = &entries[key & mask & ~uint64_t(1)];
+  MateEntry * replace = &slot[0];
+  if(slot[1].key == key || (slot[0].key != key && slot[1].work < slot[0].work)){
+    replace = &slot[1];
+  }
+  replace->key = key;
+  replace->phi = phi;
+  replace->delta = delta;
+  replace->work = uint32_t(min(work, long(UINT32_MAX)));
+  replace->distance = uint16_t(distance);
+}
+
+void MateSolver::node_moves(gameState & state, bool attacking, MoveList & moves){
+  moves.count = 0;
+  state.generate_moves(moves, state.active_color);
+  if(!attacking || !checksOnly) return;
+  int kept = 0;
+  for(int k = 0; k < moves.count; k++){
+    if(state.gives_check(moves.moves[k])) moves.moves[kept++] = moves.moves[k];
+  }
+  moves.count = kept;
+}
+
+MateStatus MateSolver::solve(gameState & root, int maxMoves){
+  nodes = 0;
+  lineLength = 0;
+  stopped = false;
+  int plies = max(1, min(2 * maxMoves - 1, MAX_PLY - 1));
+  MateStatus status = MATE_NONE;
+  //Prove a mate, then look for one two plies shorter until there is none. Results are stored by plies left,
+  //so everything learned on the longer tries still counts on the shorter ones
+  while(plies >= 1){
+    path[0] = root.key;
+    mid(root, plies, true, PROOF_INFINITY, PROOF_INFINITY, 0);
+    MateEntry * entry = probe(root.key, plies);
+    if(stopped || entry == NULL || (entry->phi != 0 && entry->delta != 0)){
+      //Out of nodes. A mate already found is still a mate, just maybe not the shortest
+      return (status == MATE_FOUND ? MATE_FOUND : MATE_UNKNOWN);
+    }
+    if(entry->phi != 0){
+      break;
+    }
+    Move found[MAX_PLY + 1];
+    int foundLength = lineLength;
+    copy(line, line + lineLength, found);
+    if(!extract_line(root, plies, true, 0)){
+      //Keep the last line that could be followed, if any
+      copy(found, found + foundLength, line);
+      lineLength = foundLength;
+      return (status == MATE_FOUND ? MATE_FOUND : MATE_UNKNOWN);
+    }
+    status = MATE_FOUND;
+    plies = lineLength - 2;
+  }
+  return status;
+}
+
+void MateSolver::mid(gameState & state, int plies, bool attacking, uint32_t phiLimit, uint32_t deltaLimit, int ply){
+  long startNodes = nodes++;
+  if(nodeLimit > 0 && nodes >= nodeLimit) stopped = true;
+
+  MoveList moves;
+  node_moves(state, attacking, moves);
+  //Positions with nothing to search are finished. Only a defender checkmated is a win for the attacker,
+  //anything else that ends the line is the attacker failing
+  if(moves.count == 0 || plies == 0){
+    bool mated = !attacking && moves.count == 0 && state.in_check();
+    bool attackerWins = mated;
+    //phi is for the color to move: the attacker wins with phi 0, the defender wins with phi 0
+    bool moverWins = (attacking ? attackerWins : !attackerWins);
+    store(state.key, plies, moverWins ? 0 : PROOF_INFINITY, moverWins ? PROOF_INFINITY : 0, 0, 1);
+    return;
+  }
+
+  //Children start from the table, or at 1 and 1 if they have not been seen. A repetition is a win for the defender
+  uint32_t childPhi[MAX_MOVES];
+  uint32_t childDelta[MAX_MOVES];
+  for(int k = 0; k < moves.count; k++){
+    gameState next = state;
+    next.apply_move(moves.moves[k]);
+    bool repeated = false;
+    for(int p = ply - 1; p >= 0 && !repeated; p -= 2){
+      repeated = (path[p] == next.key);
+    }
+    MateEntry * entry = probe(next.key, plies - 1);
+    if(repeated){
+      //The child's mover is the defender if this node is the attacker's
+      childPhi[k] = attacking ? 0 : PROOF_INFINITY;
+      childDelta[k] = attacking ? PROOF_INFINITY : 0;
+    } else if(entry != NULL){
+      childPhi[k] = entry->phi;
+      childDelta[k] = entry->delta;
+    } else {
+      childPhi[k] = 1;
+      childDelta[k] = 1;
+    }
+  }
+
+  uint32_t phi = 0;
+  uint32_t delta = 0;
+  while(true){
+    //This node's phi is the smallest child delta, its delta the sum of the child phis
+    int best = 0;
+    uint32_t secondDelta = PROOF_INFINITY;
+    phi = PROOF_INFINITY;
+    delta = 0;
+    for(int k = 0; k < moves.count; k++){
+      if(childDelta[k] < phi){
+        secondDelta = phi;
+        phi = childDelta[k];
+        best = k;
+      } else if(childDelta[k] < secondDelta){
+        secondDelta = childDelta[k];
+      }
+      delta = min(PROOF_INFINITY, delta + childPhi[k]);
+    }
+    if(phi >= phiLimit || delta >= deltaLimit || stopped){
+      break;
+    }
+
+    //Search the most promising child until it is no longer the most promising one or this node is done
+    int64_t childPhiLimit = int64_t(deltaLimit) + childPhi[best] - delta;
+    int64_t childDeltaLimit = min(int64_t(phiLimit), int64_t(secondDelta) + 1);
+    gameState next = state;
+    next.apply_move(moves.moves[best]);
+    path[ply + 1] = next.key;
+    mid(next, plies - 1, !attacking, uint32_t(min(int64_t(PROOF_INFINITY), childPhiLimit)),
+        uint32_t(min(int64_t(PROOF_INFINITY), childDeltaLimit)), ply + 1);
+    MateEntry * entry = probe(next.key, plies - 1);
+    if(entry == NULL){
+      //Pushed out of the table by its own subtree, which only happens when the table is far too small
+      stopped = true;
+      break;
+    }
+    childPhi[best] = entry->phi;
+    childDelta[best] = entry->delta;
+  }
+
+  //Once the attacker's win is proven, remember how far away the mate is: the attacker's quickest proven
+  //mate, or the defender's longest way out
+  int distance = 0;
+  bool attackerWins = (attacking ? phi == 0 : delta == 0);
+  if(attackerWins){
+    distance = (attacking ? MAX_PLY : 0);
+    for(int k = 0; k < moves.count; k++){
+      bool proven = (attacking ? childDelta[k] == 0 : childPhi[k] == 0);
+      if(!proven) continue;
+      gameState next = state;
+      next.apply_move(moves.moves[k]);
+      MateEntry * entry = probe(next.key, plies - 1);
+      int childDistance = (entry != NULL ? entry->distance : plies - 1);
+      distance = (attacking ? min(distance, childDistance + 1) : max(distance, childDistance + 1));
+    }
+  }
+  store(state.key, plies, phi, delta, distance, nodes - startNodes);
+}
+
+bool MateSolver::extract_line(gameState & state, int plies, bool attacking, int ply){
+  MoveList moves;
+  node_moves(state, attacking, moves);
+  if(moves.count == 0){
+    lineLength = ply;
+    return !attacking && state.in_check();
+  }
+  if(plies == 0 || ply >= MAX_PLY){
+    return false;
+  }
+
+  //The attacker plays the proven move with the nearest mate, the defender the move with the farthest
+  int best = -1;
+  int bestDistance = 0;
+  for(int k = 0; k < moves.count; k++){
+    gameState next = state;
+    next.apply_move(moves.moves[k]);
+    MateEntry * entry = probe(next.key, plies - 1);
+    bool proven = (entry != NULL && (attacking ? entry->delta == 0 : entry->phi == 0));
+    if(!proven && !attacking){
+      //Every defense has to be proven, so one that fell out of the table is proven again
+      path[ply + 1] = next.key;
+      mid(next, plies - 1, true, PROOF_INFINITY, PROOF_INFINITY, ply + 1);
+      entry = probe(next.key, plies - 1);
+      proven = (entry != NULL && entry->phi == 0);
+      if(!proven) return false;
+    }
+    if(!proven) continue;
+    if(best < 0 || (attacking ? entry->distance < bestDistance : entry->distance > bestDistance)){
+      best = k;
+      bestDistance = entry->distance;
+    }
+  }
+  if(best < 0){
+    return false;
+  }
+  line[ply] = moves.moves[best];
+  gameState next = state;
+  next.apply_move(moves.moves[best]);
+  path[ply + 1] = next.key;
+  return extract_line(next, plies - 1, !attacking, ply + 1);
+}
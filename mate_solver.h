@@ -0,0 +1,88 @@
+#ifndef MATE_SOLVER_H
+#define MATE_SOLVER_H
+#include "game_logic.h"
+#include "hash_memory.h"
+#include "search_stack.h"
+
+const int DEFAULT_MATE_HASH_MB = 64;
+const uint32_t PROOF_INFINITY = 100000000;  //Proof or disproof number of a finished node
+
+//What the mate solver knows about one position, searched with a number of plies left. The numbers are from the
+//point of view of the color to move: phi is the proof number of it winning and delta the proof number of it losing
+struct MateEntry {
+  uint64_t key;       //Position key mixed with the plies left, 0 for an empty entry
+  uint32_t phi;
+  uint32_t delta;
+  uint32_t work;      //Nodes searched below this entry, the entry with less work is replaced first
+  uint16_t distance;  //Plies to mate once the attacker's win is proven
+  uint16_t unused;
+};
+
+enum MateStatus {
+  MATE_UNKNOWN,   //Node limit reached before a proof or a disproof
+  MATE_FOUND,     //line is a forced mate
+  MATE_NONE       //No forced mate within the move limit
+};
+
+//Depth-first proof-number search (df-pn) for forced mates, separate from the alpha-beta search.
+//Proof numbers steer the search toward the moves that are cheapest to prove or refute, which finds long
+//forced mates that alpha-beta would need every ply of to see. The solver has its own hash table, since its
+//entries are proof numbers and not scores. Once a mate is proven the solver tries again two plies shorter
+//until that fails, so the line it gives is the shortest mate.
+class MateSolver{
+  public:
+    bool checksOnly;           //Only try checking moves for the attacker, much faster for puzzles that are all checks
+    long nodeLimit;            //Give up after this many nodes, 0 for no limit
+    long nodes;                //Nodes searched by the last solve
+    Move line[MAX_PLY + 1];    //Mate line found by the last solve, attacker's move first
+    int lineLength;            //Plies in line, 0 if no mate was found
+
+    //PRE : hashMB must be at least 1
+    //POST: the hash table is allocated
+    MateSolver(int hashMB = DEFAULT_MATE_HASH_MB);
+    ~MateSolver();
+
+    //PRE : root must be populated correctly, maxMoves must be between 1 and MAX_PLY / 2
+    //POST: returns MATE_FOUND and fills in line if the color to move can force mate in maxMoves moves or fewer,
+    //      MATE_NONE if it cannot and MATE_UNKNOWN if the node limit ran out first
+    //DESC: A repetition counts as the attacker failing. The fifty move rule is not checked
+    MateStatus solve(gameState & root, int maxMoves);
+
+    //PRE : None
+    //POST: every entry is empty
+    void clear();
+
+  private:
+    HashMemory memory;
+    MateEntry * entries;
+    uint64_t mask;
+    uint64_t depthKeys[MAX_PLY + 1];  //Mixed into the key so results for different plies left never mix
+    uint64_t path[MAX_PLY + 1];       //Keys of the positions on the current path, for repetitions
+    bool stopped;                     //TRUE once nodeLimit is reached
+
+    //PRE : None
+    //POST: returns the entry for key with plies left, or NULL if there is none
+    MateEntry * probe(uint64_t key, int plies);
+
+    //PRE : None
+    //POST: the result for key with plies left is stored, replacing the entry with less work if needed
+    void store(uint64_t key, int plies, uint32_t phi, uint32_t delta, int distance, long work);
+
+    //PRE : state must be populated correctly, plies must be at least 0
+    //POST: the entry for state holds proof numbers at or over one of the thresholds, or a finished result
+    //DESC: The multiple iterative deepening step of df-pn. attacking is TRUE if the attacker is to move
+    void mid(gameState & state, int plies, bool attacking, uint32_t phiLimit, uint32_t deltaLimit, int ply);
+
+    //PRE : mid must have proven state a win for the attacker with plies left
+    //POST: returns TRUE with the mate in line from ply on and lineLength at its end, FALSE if the proof could not be followed
+    //DESC: The attacker takes the quickest proven mate, the defender the longest. Entries lost from the table are
+    //      proven again on the way
+    bool extract_line(gameState & state, int plies, bool attacking, int ply);
+
+    //PRE : state must be populated correctly
+    //POST: moves holds the moves searched from state
+    //DESC: Every valid move, or only the checks for the attacker when checksOnly is set
+    void node_moves(gameState & state, bool attacking, MoveList & moves);
+};
+
+#endif
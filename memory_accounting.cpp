@@ -0,0 +1,52 @@
+#include "memory_accounting.h"
+#include <atomic>
+#include <cstdio>
+#include <sys/resource.h>
+#include "logger.h"
+
+static const char * PART_NAMES[MEMORY_PART_COUNT] = {
+  "transposition table", "eval cache", "pawn table", "search stacks", "search tables", "bitbases", "books",
+  "mate solver", "trace buffers"
+};
+
+static std::atomic<long long> charged[MEMORY_PART_COUNT];
+
+void memory_charge(MemoryPart part, long long bytes){
+  charged[part].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+size_t memory_charged(MemoryPart part){
+  long long bytes = charged[part].load(std::memory_order_relaxed);
+  return size_t(bytes > 0 ? bytes : 0);
+}
+
+size_t memory_charged_total(){
+  size_t total = 0;
+  for(int part = 0; part < MEMORY_PART_COUNT; part++){
+    total += memory_charged(MemoryPart(part));
+  }
+  return total;
+}
+
+size_t peak_resident_bytes(){
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  //Linux gives kilobytes
+  return size_t(usage.ru_maxrss) * 1024;
+}
+
+void log_memory_report(const char * when, int budgetMB){
+  const double MB = 1024.0 * 1024.0;
+  char parts[512];
+  int used = 0;
+  for(int part = 0; part < MEMORY_PART_COUNT; part++){
+    size_t bytes = memory_charged(MemoryPart(part));
+    if(bytes == 0) continue;
+    used += snprintf(parts + used, sizeof(parts) - used, "%s%s %.2f", used == 0 ? "" : ", ", PART_NAMES[part], bytes / MB);
+    if(used >= int(sizeof(parts))) used = int(sizeof(parts)) - 1;
+  }
+  parts[used] = '\0';
+  double total = memory_charged_total() / MB;
+  log_printf(total > budgetMB ? LOG_WARNING : LOG_INFO, "Memory at %s: %.1fMB of %dMB budget%s (%s), peak resident %.1fMB",
+             when, total, budgetMB, total > budgetMB ? " OVER BUDGET" : "", parts, peak_resident_bytes() / MB);
+}
@@ -0,0 +1,45 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+#include <cstddef>
+
+//Process wide count of the memory held by each of the engine's large parts. Every table charges what it
+//allocates when it is made and gives it back when it is destroyed, so the report always matches what is
+//really held, across every engine in the process.
+
+enum MemoryPart {
+  MEMORY_TRANSPOSITION_TABLE,
+  MEMORY_EVAL_CACHE,
+  MEMORY_PAWN_TABLE,
+  MEMORY_SEARCH_STACKS,    //Each Search's arena of frames and keys
+  MEMORY_SEARCH_TABLES,    //History and late move reduction tables
+  MEMORY_BITBASES,
+  MEMORY_BOOKS,
+  MEMORY_MATE_SOLVER,
+  MEMORY_TRACE_BUFFERS,    //Only while a search is traced
+  MEMORY_PART_COUNT
+};
+
+//PRE : None
+//POST: bytes are added to part's count, or taken off it if negative
+//DESC: Safe to call from any thread
+void memory_charge(MemoryPart part, long long bytes);
+
+//PRE : None
+//POST: returns the bytes part holds now
+size_t memory_charged(MemoryPart part);
+
+//PRE : None
+//POST: returns the bytes every part holds now
+size_t memory_charged_total();
+
+//PRE : None
+//POST: returns the most the process has had in physical memory so far, in bytes, or 0 if unknown
+size_t peak_resident_bytes();
+
+//PRE : None
+//POST: one line with each part's megabytes, the total, the budget and the peak resident memory is logged,
+//      as a warning if the total is over budgetMB
+//DESC: when says what point of the game this is, like "start" or "end"
+void log_memory_report(const char * when, int budgetMB);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MOVE_H
+#define MOVE_H
+#include <cstdint>
+#include <string>
+using namespace std;
+
+//A move packed into 16 bits: the from space in bits 0-5, the to space in bits 6-11 and the piece
+//a pawn is promoted to in bits 12-14. Spaces are numbered x*8 + y like the attack tables.
+//Moves are only turned into UCI strings when they leave the engine
+typedef uint16_t Move;
+
+const Move NO_MOVE = 0;     //From and to the same space, never a real move
+const int MAX_MOVES = 256;  //More than the most valid moves any position can have
+
+enum { PROMOTE_NONE = 0, PROMOTE_KNIGHT = 1, PROMOTE_BISHOP = 2, PROMOTE_ROOK = 3, PROMOTE_QUEEN = 4 };
+
+//PRE : startx, starty, x, y must be between 0 and 7 (valid board space)
+//POST: returns the packed move from start(x,y) to (x,y)
+//DESC: Packed version of move_string
+inline Move pack_move(int startx, int starty, int x, int y, int promotion = PROMOTE_NONE){
+  return Move((startx*8 + starty) | ((x*8 + y) << 6) | (promotion << 12));
+}
+
+inline int move_from(Move move){
+  return move & 63;
+}
+
+inline int move_to(Move move){
+  return (move >> 6) & 63;
+}
+
+inline int move_promotion(Move move){
+  return move >> 12;
+}
+
+//PRE : None
+//POST: returns the move in UCI notation, with the promotion piece in lower case
+//DESC: Strings this short fit inside std::string itself, so this does not allocate
+inline string move_to_uci(Move move){
+  string uci = "";
+  uci.push_back(char('a' + move_from(move)%8));
+  uci.push_back(char('8' - move_from(move)/8));
+  uci.push_back(char('a' + move_to(move)%8));
+  uci.push_back(char('8' - move_to(move)/8));
+  if(move_promotion(move) != PROMOTE_NONE){
+    uci.push_back("-nbrq"[move_promotion(move)]);
+  }
+  return uci;
+}
+
+//PRE : uci must be a move in UCI notation
+//POST: returns the packed move
+//DESC: Accepts the promotion piece in either case
+inline Move uci_to_move(const string & uci){
+  int promotion = PROMOTE_NONE;
+  if(uci.length() > 4){
+    switch(uci[4]){
+      case 'n': case 'N': promotion = PROMOTE_KNIGHT; break;
+      case 'b': case 'B': promotion = PROMOTE_BISHOP; break;
+      case 'r': case 'R': promotion = PROMOTE_ROOK; break;
+      case 'q': case 'Q': promotion = PROMOTE_QUEEN; break;
+    }
+  }
+  return pack_move('8' - uci[1], uci[0] - 'a', '8' - uci[3], uci[2] - 'a', promotion);
+}
+
+//Fixed size list of moves, filled by the move generator without allocating
+struct MoveList {
+  Move moves[MAX_MOVES];
+  int count;
+
+  MoveList() : count(0) {}
+
+  void add(Move move){
+    moves[count++] = move;
+  }
+};
+
+#endif
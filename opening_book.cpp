@@ -0,0 +1,52 @@
+#include "opening_book.h"
+#include <algorithm>
+#include <cstdio>
+#include "memory_accounting.h"
+
+bool write_book(const string & path, const vector<BookEntry> & entries){
+  FILE * file = fopen(path.c_str(), "wb");
+  if(file == NULL) return false;
+  size_t written = (entries.empty() ? 0 : fwrite(entries.data(), sizeof(BookEntry), entries.size(), file));
+  bool closed = (fclose(file) == 0);
+  return closed && written == entries.size();
+}
+
+OpeningBook::OpeningBook(){
+  chargedBytes = 0;
+}
+
+OpeningBook::~OpeningBook(){
+  memory_charge(MEMORY_BOOKS, -(long long)chargedBytes);
+}
+
+bool OpeningBook::open(const string & path){
+  //Give back the last book's memory, not just its entries
+  vector<BookEntry>().swap(entries);
+  memory_charge(MEMORY_BOOKS, -(long long)chargedBytes);
+  chargedBytes = 0;
+  FILE * file = fopen(path.c_str(), "rb");
+  if(file == NULL) return false;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  entries.resize(size > 0 ? size / sizeof(BookEntry) : 0);
+  size_t read = (entries.empty() ? 0 : fread(entries.data(), sizeof(BookEntry), entries.size(), file));
+  fclose(file);
+  entries.resize(read);
+  chargedBytes = entries.capacity() * sizeof(BookEntry);
+  memory_charge(MEMORY_BOOKS, chargedBytes);
+  return true;
+}
+
+//Orders entries and keys by key only, for lower_bound and upper_bound
+struct BookKeyOrder {
+  bool operator()(const BookEntry & entry, uint64_t key) const { return entry.key < key; }
+  bool operator()(uint64_t key, const BookEntry & entry) const { return key < entry.key; }
+};
+
+int OpeningBook::find(uint64_t key, const BookEntry * & first) const{
+  vector<BookEntry>::const_iterator low = lower_bound(entries.begin(), entries.end(), key, BookKeyOrder());
+  vector<BookEntry>::const_iterator high = upper_bound(low, entries.end(), key, BookKeyOrder());
+  first = (low == entries.end() ? NULL : &*low);
+  return int(high - low);
+}
@@ -0,0 +1,51 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+#include <cstdint>
+#include "game_logic.h"
+
+//One move seen in one position, 24 bytes with no padding so a book file is a plain array.
+//Entries are sorted by key, and by games played from most to fewest within a key.
+//Multi-byte fields are stored in the machine's byte order, little endian on every machine this runs on
+struct BookEntry {
+  uint64_t key;     //gameState::key of the position before the move
+  Move move;
+  uint16_t unused;
+  uint32_t games;   //Games the move was played in
+  uint32_t wins;    //Of those, games the side that played the move won
+  uint32_t draws;   //and drew. The rest were lost
+};
+
+static_assert(sizeof(BookEntry) == 24, "BookEntry must be packed");
+
+//PRE : entries must be sorted as described for BookEntry
+//POST: returns FALSE if path could not be written
+//DESC: Write a book file
+bool write_book(const string & path, const vector<BookEntry> & entries);
+
+//A book file read into memory, looked up by binary search on the key
+class OpeningBook{
+  public:
+    vector<BookEntry> entries;
+
+    OpeningBook();
+    ~OpeningBook();
+
+    //PRE : None
+    //POST: returns FALSE if path could not be read, entries then is empty
+    //DESC: Read a book written by write_book. A partly written entry at the end of the file is left out
+    bool open(const string & path);
+
+    //PRE : None
+    //POST: first points to the position's entries, most played first, and the number of them is returned.
+    //      returns 0 if the position is not in the book
+    //DESC: Find the book moves of a position
+    int find(uint64_t key, const BookEntry * & first) const;
+
+  private:
+    size_t chargedBytes;  //Size of the entries read by open, as charged to MEMORY_BOOKS
+
+    OpeningBook(const OpeningBook &);
+    OpeningBook & operator=(const OpeningBook &);
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "packed_position.h"
+
+void pack_position(gameState & state, PackedPosition & packed){
+  memset(&packed, 0, sizeof(packed));
+  int count = 0;
+  //Spaces in increasing order, the same order decoding walks the occupancy bits
+  for(int s = 0; s < 64; s++){
+    char piece = state.gameBoard[s/8][s%8];
+    if(piece == '-') continue;
+    packed.occupancy |= uint64_t(1) << s;
+    packed.pieces[count/2] |= uint8_t(piece_index(piece) << (count%2 ? 4 : 0));
+    count++;
+  }
+  packed.sideToMove = (state.active_color == "white" ? WHITE : BLACK);
+  packed.castling = uint8_t(castling_mask(state.castling));
+  packed.enPassant = (state.en_passant == "-" ? 0 : uint8_t(state.en_passant[0] - 'a' + 1));
+  packed.halfmoveClock = uint8_t(state.halfmove_clock < 255 ? state.halfmove_clock : 255);
+  packed.fullmoveNumber = uint16_t(state.fullmove_number);
+}
+
+void unpack_position(const PackedPosition & packed, gameState & state){
+  const char * pieces = "PNBRQKpnbrqk";
+  for(int i = 0; i < 8; i++){
+    for(int j = 0; j < 8; j++){
+      state.gameBoard[i][j] = '-';
+    }
+  }
+  uint64_t occupied = packed.occupancy;
+  for(int count = 0; occupied; count++){
+    int s = pop_lsb(occupied);
+    state.gameBoard[s/8][s%8] = pieces[(packed.pieces[count/2] >> (count%2 ? 4 : 0)) & 15];
+  }
+  state.active_color = (packed.sideToMove == WHITE ? "white" : "black");
+  state.castling = "";
+  if(packed.castling & 1) state.castling += "K";
+  if(packed.castling & 2) state.castling += "Q";
+  if(packed.castling & 4) state.castling += "k";
+  if(packed.castling & 8) state.castling += "q";
+  if(state.castling == "") state.castling = "-";
+  if(packed.enPassant == 0){
+    state.en_passant = "-";
+  } else {
+    //The pawn that can be taken just moved two spaces, so the space behind it is on the 6th rank
+    //if white is to move and the 3rd if black is
+    state.en_passant = "";
+    state.en_passant += char('a' + packed.enPassant - 1);
+    state.en_passant += (packed.sideToMove == WHITE ? '6' : '3');
+  }
+  state.halfmove_clock = packed.halfmoveClock;
+  state.fullmove_number = packed.fullmoveNumber;
+  state.isFirstMove = (packed.fullmoveNumber <= 1 && packed.sideToMove == WHITE);
+  state.index_pieces();
+  state.compute_keys();
+}
+
+uint64_t packed_key(const PackedPosition & packed){
+  uint64_t key = 0;
+  uint64_t occupied = packed.occupancy;
+  for(int count = 0; occupied; count++){
+    int s = pop_lsb(occupied);
+    key ^= ZOBRIST.piece[(packed.pieces[count/2] >> (count%2 ? 4 : 0)) & 15][s];
+  }
+  key ^= ZOBRIST.castling[packed.castling];
+  if(packed.enPassant != 0){
+    key ^= ZOBRIST.en_passant[packed.enPassant - 1];
+  }
+  if(packed.sideToMove == BLACK){
+    key ^= ZOBRIST.side;
+  }
+  return key;
+}
@@ -0,0 +1,82 @@
+#ifndef PACKED_POSITION_H
+#define PACKED_POSITION_H
+#include <cstdint>
+#include <cstring>
+#include "game_logic.h"
+
+//A position in 32 bytes: which spaces hold a piece, then a 4 bit code for each of those pieces in space order.
+//Blank bits are always zero, so each position has exactly one packing and two packings can be compared
+//as bytes. Fast to copy, hash and store in caches, books and datasets, unlike a fen string.
+//Multi-byte fields are stored in the machine's byte order
+struct PackedPosition {
+  uint64_t occupancy;     //Bit x*8 + y set for each space with a piece on it
+  uint8_t pieces[16];     //piece_index of each piece in order of occupancy bits, low 4 bits first
+  uint8_t sideToMove;     //WHITE or BLACK
+  uint8_t castling;       //castling_mask of the castling rights
+  uint8_t enPassant;      //Column of the en passant space + 1, 0 if there is none
+  uint8_t halfmoveClock;  //Capped at 255
+  uint16_t fullmoveNumber;
+  uint8_t unused[2];
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must be 32 bytes");
+
+//Bytes of a PackedPosition that gameState::key covers. The move counters come after them
+const size_t PACKED_HASHED_BYTES = offsetof(PackedPosition, halfmoveClock);
+
+//PRE : state must be populated correctly with at most 32 pieces
+//POST: packed holds the position
+//DESC: Encode a position
+void pack_position(gameState & state, PackedPosition & packed);
+
+//PRE : packed must have been made by pack_position
+//POST: state holds the position, with keys computed. isFirstMove is TRUE only for white's first move
+//      of a game, since the packing keeps no move history
+//DESC: Decode a position without going through a fen string
+void unpack_position(const PackedPosition & packed, gameState & state);
+
+//PRE : packed must have been made by pack_position
+//POST: returns the gameState::key the position would have once unpacked
+//DESC: Hash a packed position without unpacking it
+uint64_t packed_key(const PackedPosition & packed);
+
+//Two packings are equal when gameState::key would see the same position: same pieces, side to move,
+//castling and en passant. The move counters are left out, the same as in the key
+inline bool operator==(const PackedPosition & a, const PackedPosition & b){
+  return memcmp(&a, &b, PACKED_HASHED_BYTES) == 0;
+}
+
+inline bool operator!=(const PackedPosition & a, const PackedPosition & b){
+  return !(a == b);
+}
+
+//Orders by the hashed bytes, for sets and sorting when the order itself does not matter.
+//Use KeyedPosition to order by key
+inline bool operator<(const PackedPosition & a, const PackedPosition & b){
+  return memcmp(&a, &b, PACKED_HASHED_BYTES) < 0;
+}
+
+//A position with its packed_key worked out once, so sorting compares keys instead of hashing both sides of
+//every comparison. Sorted by key, a file of positions can be searched by key, and positions whose keys
+//collide are ordered by bytes
+struct KeyedPosition {
+  uint64_t key;
+  PackedPosition position;
+
+  KeyedPosition() : key(0) { memset(&position, 0, sizeof(position)); }
+  KeyedPosition(const PackedPosition & packed) : key(packed_key(packed)), position(packed) {}
+};
+
+inline bool operator<(const KeyedPosition & a, const KeyedPosition & b){
+  if(a.key != b.key) return a.key < b.key;
+  return a.position < b.position;
+}
+
+//Hash for unordered containers, the position's own key
+struct PackedPositionHash {
+  size_t operator()(const PackedPosition & packed) const {
+    return size_t(packed_key(packed));
+  }
+};
+
+#endif
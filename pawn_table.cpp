@@ -0,0 +1,150 @@
+#include "pawn_table.h"
+#include "memory_accounting.h"
+
+//Squares in the given columns on rows strictly in front of row x for color c
+static uint64_t front_span(int c, int x, int firstCol, int lastCol){
+  uint64_t span = 0;
+  int forward = (c == WHITE ? -1 : 1);
+  for(int i = x + forward; i >= 0 && i < 8; i += forward){
+    for(int j = firstCol; j <= lastCol; j++){
+      if(j >= 0 && j < 8) span |= square_bit(i, j);
+    }
+  }
+  return span;
+}
+
+//Squares on the columns next to y on row x and the rows behind it for color c,
+//the squares a friendly pawn could defend the pawn on (x,y) from by moving forward
+static uint64_t support_span(int c, int x, int y){
+  uint64_t span = 0;
+  int backward = (c == WHITE ? 1 : -1);
+  for(int i = x; i >= 0 && i < 8; i += backward){
+    if(y > 0) span |= square_bit(i, y-1);
+    if(y < 7) span |= square_bit(i, y+1);
+  }
+  return span;
+}
+
+static uint64_t adjacent_files(int y){
+  uint64_t files = 0;
+  for(int i = 0; i < 8; i++){
+    if(y > 0) files |= square_bit(i, y-1);
+    if(y < 7) files |= square_bit(i, y+1);
+  }
+  return files;
+}
+
+void evaluate_pawns(char gameBoard[][8], PawnEntry & entry, EvalTrace * trace){
+  uint64_t pawns[2] = {0, 0};
+  for(int i = 0; i < 8; i++){
+    for(int j = 0; j < 8; j++){
+      if(gameBoard[i][j] == 'P') pawns[WHITE] |= square_bit(i, j);
+      if(gameBoard[i][j] == 'p') pawns[BLACK] |= square_bit(i, j);
+    }
+  }
+
+  entry.score = 0;
+  for(int c = WHITE; c <= BLACK; c++){
+    int sign = (c == WHITE ? 1 : -1);
+    int forward = (c == WHITE ? -1 : 1);
+    uint64_t own = pawns[c];
+    uint64_t enemy = pawns[1-c];
+    entry.passed[c] = 0;
+
+    uint64_t remaining = own;
+    while(remaining){
+      int s = pop_lsb(remaining);
+      int x = s/8;
+      int y = s%8;
+      bool isolated = !(own & adjacent_files(y));
+
+      //No enemy pawn can block or take it on the way to promotion
+      if(!(enemy & front_span(c, x, y-1, y+1))){
+        entry.passed[c] |= square_bit(x, y);
+        int advanced = (c == WHITE ? 6 - x : x - 1);
+        entry.score += sign * EVAL_WEIGHTS.passedBonus[advanced];
+        if(trace != NULL) trace->counts.passedBonus[advanced] += sign;
+      }
+      //Only the rear pawn of a doubled pair is penalized, so each extra pawn counts once
+      if(own & front_span(c, x, y, y)){
+        entry.score -= sign * EVAL_WEIGHTS.doubledPenalty;
+        if(trace != NULL) trace->counts.doubledPenalty -= sign;
+      }
+      if(isolated){
+        entry.score -= sign * EVAL_WEIGHTS.isolatedPenalty;
+        if(trace != NULL) trace->counts.isolatedPenalty -= sign;
+      }
+      //Backward: no friendly pawn can ever defend it, and an enemy pawn guards the space in front of it
+      else if(!(own & support_span(c, x, y)) && x + forward >= 0 && x + forward < 8 &&
+              (enemy & PAWN_ATTACKS.sq[c][(x + forward)*8 + y])){
+        entry.score -= sign * EVAL_WEIGHTS.backwardPenalty;
+        if(trace != NULL) trace->counts.backwardPenalty -= sign;
+      }
+    }
+
+    //Shield in front of a king standing on the back rank of each file
+    int backRank = (c == WHITE ? 7 : 0);
+    for(int f = 0; f < 8; f++){
+      entry.shield[c][f] = 0;
+      for(int j = f-1; j <= f+1; j++){
+        if(j < 0 || j > 7) continue;
+        if(own & square_bit(backRank + forward, j)){
+          entry.shield[c][f] += EVAL_WEIGHTS.shieldNearBonus;
+          if(trace != NULL) trace->shield[c][f][0]++;
+        } else if(own & square_bit(backRank + 2*forward, j)){
+          entry.shield[c][f] += EVAL_WEIGHTS.shieldFarBonus;
+          if(trace != NULL) trace->shield[c][f][1]++;
+        } else {
+          entry.shield[c][f] -= EVAL_WEIGHTS.shieldMissingPenalty;
+          if(trace != NULL) trace->shield[c][f][2]--;
+        }
+      }
+    }
+  }
+}
+
+PawnTable::PawnTable(int sizeMB){
+  uint64_t count = 1;
+  while(count * 2 * sizeof(PawnEntry) <= uint64_t(sizeMB) * 1024 * 1024){
+    count *= 2;
+  }
+  entries.resize(count);
+  mask = count - 1;
+  memory_charge(MEMORY_PAWN_TABLE, entries.size() * sizeof(PawnEntry));
+  clear();
+}
+
+PawnTable::~PawnTable(){
+  memory_charge(MEMORY_PAWN_TABLE, -(long long)(entries.size() * sizeof(PawnEntry)));
+}
+
+void PawnTable::clear(){
+  //A board with no pawns hashes to 0, so filling the table with its evaluation
+  //means every entry is valid without needing a separate flag
+  char blank[8][8];
+  for(int i = 0; i < 8; i++){
+    for(int j = 0; j < 8; j++){
+      blank[i][j] = '-';
+    }
+  }
+  PawnEntry empty;
+  empty.key = 0;
+  evaluate_pawns(blank, empty);
+  for(size_t i = 0; i < entries.size(); i++){
+    entries[i] = empty;
+  }
+  probes = 0;
+  hits = 0;
+}
+
+PawnEntry & PawnTable::probe(char gameBoard[][8], uint64_t pawnKey){
+  probes++;
+  PawnEntry & entry = entries[pawnKey & mask];
+  if(entry.key == pawnKey){
+    hits++;
+    return entry;
+  }
+  entry.key = pawnKey;
+  evaluate_pawns(gameBoard, entry);
+  return entry;
+}
@@ -0,0 +1,51 @@
+#ifndef PAWN_TABLE_H
+#define PAWN_TABLE_H
+#include "game_logic.h"
+#include "eval_weights.h"
+
+//Pawn structure evaluation of one arrangement of pawns. Scores are in centipawns
+struct PawnEntry {
+  uint64_t key;         //pawnKey of the pawns the entry was computed for
+  int score;            //passed, isolated, doubled and backward pawn score, white minus black
+  int shield[2][8];     //pawn shield score for a king of each color (WHITE, BLACK) on its back rank on each file
+  uint64_t passed[2];   //squares of each color's passed pawns
+};
+
+//PRE : gameBoard must be filled in with letters or dashes '-'
+//POST: entry's scores and passed pawns are filled in for the pawns on gameBoard. The key is not changed.
+//      If trace is given the pawn weight counts and shield counts are added to it
+//DESC: Full pawn structure evaluation. Only the pawns on the board are looked at
+void evaluate_pawns(char gameBoard[][8], PawnEntry & entry, EvalTrace * trace = NULL);
+
+//Hash table of pawn structure evaluations, indexed by gameState::pawnKey.
+//Pawns move rarely compared to the other pieces, so most lookups during a search are hits.
+class PawnTable{
+  public:
+    long probes;  //Number of lookups since the last clear
+    long hits;    //Number of lookups that found the pawns already evaluated
+
+    //PRE : sizeMB must be at least 1
+    //POST: table is allocated with the largest power of two number of entries that fits in sizeMB
+    //DESC: Create an empty pawn table
+    PawnTable(int sizeMB = 1);
+    ~PawnTable();
+
+    //PRE : None
+    //POST: every entry holds the evaluation of a board with no pawns, counters are reset
+    //DESC: Forget everything stored in the table
+    void clear();
+
+    //PRE : pawnKey must be the pawnKey of gameBoard
+    //POST: returns the entry for gameBoard's pawns, evaluating them first if they were not stored
+    //DESC: Look up the pawn structure evaluation of a board
+    PawnEntry & probe(char gameBoard[][8], uint64_t pawnKey);
+
+  private:
+    vector<PawnEntry> entries;
+    uint64_t mask;  //entries.size() - 1, used to turn a key into an index
+
+    PawnTable(const PawnTable &);
+    PawnTable & operator=(const PawnTable &);
+};
+
+#endif
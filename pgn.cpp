@@ -0,0 +1,247 @@
+#include "pgn.h"
+#include <cctype>
+#include <cstring>
+
+//PRE : from and to must be on the board
+//POST: returns TRUE if every space between from and to is blank
+static bool clear_between(gameState & state, int from, int to){
+  uint64_t squares = BETWEEN.sq[from][to];
+  while(squares){
+    int s = pop_lsb(squares);
+    if(state.gameBoard[s/8][s%8] != '-') return false;
+  }
+  return true;
+}
+
+//PRE : move must be a move of a piece of active_color onto a blank or enemy space
+//POST: returns TRUE if the move does not leave active_color's king in check
+//DESC: Simulate the move on a copy of the board, including the pawn taken by an en passant move
+static bool leaves_king_safe(gameState & state, Move move){
+  char board[8][8];
+  int from = move_from(move);
+  int to = move_to(move);
+  char piece = state.gameBoard[from/8][from%8];
+  copyBoard(state.gameBoard, board, piece, from/8, from%8, to/8, to%8);
+  bool pawn = (piece == 'P' || piece == 'p');
+  if(pawn && from%8 != to%8 && state.gameBoard[to/8][to%8] == '-'){
+    board[from/8][to%8] = '-';
+  }
+  int king = ((piece == 'K' || piece == 'k') ? to : state.king_square(state.active_color));
+  return !isKingCheck(board, state.active_color, king/8, king%8);
+}
+
+//PRE : state must be populated correctly
+//POST: returns the castling move to the king's side or the queen's side, or NO_MOVE if it is not legal
+//DESC: Castling is rare enough that generating every move to find it costs nothing
+static Move castling_move(gameState & state, bool kingside){
+  MoveList moves;
+  state.generate_moves(moves, state.active_color);
+  int king = state.king_square(state.active_color);
+  for(int k = 0; k < moves.count; k++){
+    if(move_from(moves.moves[k]) == king && move_to(moves.moves[k]) == king + (kingside ? 2 : -2)){
+      return moves.moves[k];
+    }
+  }
+  return NO_MOVE;
+}
+
+Move san_to_move(gameState & state, const char * san, int length){
+  //Check marks and annotations say nothing about which move it is
+  while(length > 0 && strchr("+#!?", san[length-1]) != NULL) length--;
+  if(length < 2) return NO_MOVE;
+  if((length == 3 || length == 5) && (san[0] == 'O' || san[0] == '0')){
+    return castling_move(state, length == 3);
+  }
+
+  bool white = (state.active_color == "white");
+  int promotion = PROMOTE_NONE;
+  const char * promotions = "-NBRQ";
+  char last = (length > 2 && san[length-2] == '=' ? char(toupper(san[length-1])) : san[length-1]);
+  if(strchr("NBRQ", last) != NULL){
+    promotion = int(strchr(promotions, last) - promotions);
+    length--;
+    if(length > 0 && san[length-1] == '=') length--;
+  }
+  if(length < 2 || san[length-2] < 'a' || san[length-2] > 'h' || san[length-1] < '1' || san[length-1] > '8'){
+    return NO_MOVE;
+  }
+  int x = '8' - san[length-1];
+  int y = san[length-2] - 'a';
+  int to = x*8 + y;
+  if(state.gameBoard[x][y] != '-' && !isEnemyPiece(state.gameBoard[x][y], state.active_color)){
+    return NO_MOVE;
+  }
+
+  //What is left between the piece letter and the target space picks out the piece: a column, a row or both
+  char type = (strchr("NBRQK", san[0]) != NULL ? san[0] : 'P');
+  int fromColumn = -1, fromRow = -1;
+  for(int k = (type == 'P' ? 0 : 1); k < length - 2; k++){
+    if(san[k] >= 'a' && san[k] <= 'h') fromColumn = san[k] - 'a';
+    else if(san[k] >= '1' && san[k] <= '8') fromRow = '8' - san[k];
+    else if(san[k] != 'x' && san[k] != '-' && san[k] != ':') return NO_MOVE;
+  }
+  bool lastRow = (x == (white ? 0 : 7));
+  if(type == 'P' ? lastRow != (promotion != PROMOTE_NONE) : promotion != PROMOTE_NONE){
+    return NO_MOVE;
+  }
+
+  //Try each piece of the type that could reach the target, the move is only read if exactly one is legal
+  char piece = (white ? type : char(tolower(type)));
+  int p = piece_index(piece);
+  Move found = NO_MOVE;
+  for(int k = 0; k < state.pieceCount[p]; k++){
+    int from = state.pieceSquares[p][k];
+    if((fromColumn >= 0 && from%8 != fromColumn) || (fromRow >= 0 && from/8 != fromRow)) continue;
+    bool reaches = false;
+    switch(type){
+      case 'P': {
+        int dir = (white ? -1 : 1);
+        if(from%8 == y){
+          //Straight ahead onto a blank space, one space or two from the starting row
+          reaches = state.gameBoard[x][y] == '-' &&
+                    (from/8 + dir == x || (from/8 == (white ? 6 : 1) && from/8 + 2*dir == x &&
+                                           state.gameBoard[from/8 + dir][y] == '-'));
+        } else {
+          //Diagonally onto an enemy, or onto the en passant space
+          bool enPassant = (state.en_passant != "-" && state.en_passant[0] - 'a' == y && '8' - state.en_passant[1] == x);
+          reaches = (PAWN_ATTACKS.sq[white ? WHITE : BLACK][from] & square_bit(x, y)) &&
+                    (state.gameBoard[x][y] != '-' || enPassant);
+        }
+        break;
+      }
+      case 'N':
+        reaches = (KNIGHT_ATTACKS.sq[from] & square_bit(x, y)) != 0;
+        break;
+      case 'K':
+        reaches = (KING_ATTACKS.sq[from] & square_bit(x, y)) != 0;
+        break;
+      default: {
+        bool straight = (from/8 == x || from%8 == y);
+        bool diagonal = (from/8 - x == from%8 - y || from/8 - x == y - from%8);
+        reaches = from != to && (type == 'Q' ? straight || diagonal : (type == 'R' ? straight : diagonal)) &&
+                  clear_between(state, from, to);
+        break;
+      }
+    }
+    if(!reaches) continue;
+    Move move = pack_move(from/8, from%8, x, y, (type == 'P' ? promotion : PROMOTE_NONE));
+    if(!leaves_king_safe(state, move)) continue;
+    if(found != NO_MOVE) return NO_MOVE;
+    found = move;
+  }
+  return found;
+}
+
+//PRE : None
+//POST: returns the result named by the text, or PGN_NO_RESULT
+static int game_result(const char * text, int length){
+  if(length == 3 && strncmp(text, "1-0", 3) == 0) return 1;
+  if(length == 3 && strncmp(text, "0-1", 3) == 0) return -1;
+  if(length == 7 && strncmp(text, "1/2-1/2", 7) == 0) return 0;
+  return PGN_NO_RESULT;
+}
+
+const char * find_pgn_game(const char * cursor, const char * end){
+  static const char TAG[] = "[Event ";
+  const size_t tagLength = sizeof(TAG) - 1;
+  if(size_t(end - cursor) >= tagLength && memcmp(cursor, TAG, tagLength) == 0) return cursor;
+  while(cursor < end){
+    const char * newline = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+    if(newline == NULL) return end;
+    cursor = newline + 1;
+    if(size_t(end - cursor) >= tagLength && memcmp(cursor, TAG, tagLength) == 0) return cursor;
+  }
+  return end;
+}
+
+const char * read_pgn_game(const char * cursor, const char * end, PgnGame & game){
+  game.fen = STARTING_FEN;
+  game.result = PGN_NO_RESULT;
+  game.moves.clear();
+  game.complete = true;
+
+  //Tags, one per line: [Name "value"]
+  while(cursor < end){
+    while(cursor < end && isspace(*cursor)) cursor++;
+    if(cursor == end || *cursor != '[') break;
+    const char * lineEnd = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+    if(lineEnd == NULL) lineEnd = end;
+    const char * open = static_cast<const char *>(memchr(cursor, '"', lineEnd - cursor));
+    const char * close = (open == NULL ? NULL : static_cast<const char *>(memchr(open + 1, '"', lineEnd - open - 1)));
+    if(close != NULL){
+      if(strncmp(cursor, "[FEN ", 5) == 0) game.fen = string(open + 1, close);
+      if(strncmp(cursor, "[Result ", 8) == 0) game.result = game_result(open + 1, int(close - open - 1));
+    }
+    cursor = lineEnd;
+  }
+
+  gameState state;
+  state.populate_board(game.fen);
+  //Moves, until the result or the tags of the next game
+  const char * first = cursor;
+  while(cursor < end){
+    char c = *cursor;
+    if(isspace(c)){
+      cursor++;
+      continue;
+    }
+    bool lineStart = (cursor == first || cursor[-1] == '\n');
+    if(c == '[' && lineStart) return cursor;
+    if(c == '{'){
+      const char * close = static_cast<const char *>(memchr(cursor, '}', end - cursor));
+      cursor = (close == NULL ? end : close + 1);
+      continue;
+    }
+    if(c == ';' || (c == '%' && lineStart)){
+      const char * newline = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+      cursor = (newline == NULL ? end : newline + 1);
+      continue;
+    }
+    if(c == '('){
+      //Variations can hold variations and comments, only the main line is read
+      int depth = 0;
+      for(; cursor < end; cursor++){
+        if(*cursor == '{'){
+          const char * close = static_cast<const char *>(memchr(cursor, '}', end - cursor));
+          cursor = (close == NULL ? end - 1 : close);
+        } else if(*cursor == '('){
+          depth++;
+        } else if(*cursor == ')' && --depth == 0){
+          cursor++;
+          break;
+        }
+      }
+      continue;
+    }
+
+    const char * token = cursor;
+    while(cursor < end && !isspace(*cursor) && strchr("{}();[", *cursor) == NULL) cursor++;
+    int length = int(cursor - token);
+    if(length == 0){
+      cursor++;
+      continue;
+    }
+    if(token[0] == '$') continue;
+    if(game_result(token, length) != PGN_NO_RESULT || (length == 1 && token[0] == '*')){
+      game.result = game_result(token, length);
+      while(cursor < end && isspace(*cursor)) cursor++;
+      return (cursor < end && *cursor == '[' ? cursor : find_pgn_game(cursor, end));
+    }
+    //Move numbers, "12." or "12...", can be written against the move
+    if(token[0] != '0'){
+      while(length > 0 && (isdigit(*token) || *token == '.')){
+        token++;
+        length--;
+      }
+    }
+    if(length == 0 || !game.complete) continue;
+    Move move = san_to_move(state, token, length);
+    if(move == NO_MOVE){
+      game.complete = false;
+      continue;
+    }
+    game.moves.push_back(move);
+    state.apply_move(move);
+  }
+  return end;
+}
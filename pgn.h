@@ -0,0 +1,38 @@
+#ifndef PGN_H
+#define PGN_H
+#include "game_logic.h"
+
+//Reading games in PGN, the text format game databases are shared in. A game is a block of [Tag "value"]
+//lines followed by its moves in Standard Algebraic Notation (SAN), like "Nbd7", "exd6" or "e8=Q+".
+//Everything here reads straight out of a buffer, usually a memory mapped file, so a large database can
+//be split between threads at game boundaries and parsed without copying it.
+
+const int PGN_NO_RESULT = 2;  //PgnGame::result of a game that was not finished, "*"
+
+//One game read from a PGN file
+struct PgnGame {
+  string fen;              //Starting position, STARTING_FEN unless the game has a FEN tag
+  int result;              //1 white won, 0 draw, -1 black won, or PGN_NO_RESULT
+  vector<Move> moves;      //Moves of the main line, not counting variations
+  bool complete;           //FALSE if a move could not be read, moves then holds the ones before it
+};
+
+//PRE : state must be populated correctly
+//POST: returns the legal move san describes, or NO_MOVE if it describes no legal move or more than one
+//DESC: Only the pieces that could reach the target space are tried, so this is much cheaper than
+//      generating every move. Check marks, annotations like "!?" and "0-0" for castling are accepted
+Move san_to_move(gameState & state, const char * san, int length);
+
+//PRE : cursor to end must be part of a PGN file
+//POST: returns the start of the first game at or after cursor, or end if there is none
+//DESC: A game starts at an "[Event " tag at the start of a line, which every PGN game begins with.
+//      Used to split a file between threads
+const char * find_pgn_game(const char * cursor, const char * end);
+
+//PRE : cursor must be the start of a game, as returned by find_pgn_game
+//POST: game holds the game, returns where the next game starts or end
+//DESC: Reads the tags and the main line, replaying each move to read the next one.
+//      Comments, variations, move numbers and numeric annotations are skipped
+const char * read_pgn_game(const char * cursor, const char * end, PgnGame & game);
+
+#endif
@@ -0,0 +1,708 @@
+#include "search.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "bitbase.h"
+#include "logger.h"
+#include "memory_accounting.h"
+
+const int HISTORY_LIMIT = 100000;  //History scores are halved when one passes this
+
+//Mate scores are stored counted from the position instead of from the root, so they stay right
+//when the position is reached again at a different ply
+static int score_to_tt(int score, int ply){
+  if(score > MATE_SCORE - MAX_PLY) return score + ply;
+  if(score < -MATE_SCORE + MAX_PLY) return score - ply;
+  return score;
+}
+static int score_from_tt(int score, int ply){
+  if(score > MATE_SCORE - MAX_PLY) return score - ply;
+  if(score < -MATE_SCORE + MAX_PLY) return score + ply;
+  return score;
+}
+
+//Number of knights, bishops, rooks and queens color has
+static int non_pawn_pieces(gameState & state, const string & color){
+  //Knight to queen are piece indexes 1 to 4 for white and 7 to 10 for black
+  int first = (color == "white" ? piece_index('N') : piece_index('n'));
+  int count = 0;
+  for(int p = first; p < first + 4; p++){
+    count += state.pieceCount[p];
+  }
+  return count;
+}
+
+static_assert(sizeof(SearchFrame) * (MAX_PLY + 1) + sizeof(uint64_t) * (MAX_PLY + 3) <= SEARCH_ARENA_KB * 1024,
+              "the search arena must hold the frames and the keys of the deepest path");
+
+Search::Search(int pawnTableMB, int evalCacheMB, int transpositionTableMB)
+  : pawnTable(pawnTableMB), evalCache(evalCacheMB), transpositionTable(transpositionTableMB),
+    arena(SEARCH_ARENA_KB * 1024){
+  nodes = 0;
+  score = 0;
+  pvLength = 0;
+  lineCount = 0;
+  excludedCount = 0;
+  frames = NULL;
+  clock = NULL;
+  stopped = false;
+  positionKeys = NULL;
+  keyCount = 0;
+  traceBuffer = NULL;
+  traceNodes = 0;
+  traceSearches = 0;
+  traceTop = 0;
+  init_bitbases();
+  for(int i = 0; i < 64; i++){
+    for(int j = 0; j < 64; j++){
+      history[i][j] = 0;
+    }
+  }
+  memory_charge(MEMORY_SEARCH_TABLES, sizeof(history) + sizeof(reductions));
+}
+
+Search::~Search(){
+  delete traceBuffer;
+  memory_charge(MEMORY_SEARCH_TABLES, -(long long)(sizeof(history) + sizeof(reductions)));
+}
+
+string Search::best_move(gameState & root, const vector<uint64_t> & gameKeys, int maxDepth, TimeManager & clock){
+  this->clock = &clock;
+  stopped = false;
+  nodes = 0;
+  transpositionTable.new_search();
+  //A trace buffer is made, or swapped for one on a new file, before the search so nodes never allocate
+  if(traceBuffer != NULL && &traceBuffer->writer != options.trace){
+    delete traceBuffer;
+    traceBuffer = NULL;
+  }
+  if(traceBuffer == NULL && options.trace != NULL){
+    traceBuffer = new TraceBuffer(*options.trace);
+  }
+  traceSearches++;
+  traceLastRoot = -1;
+  traceTop = 0;
+  //Old history is kept but scaled down, so it still helps ordering without drowning out this search
+  for(int i = 0; i < 64; i++){
+    for(int j = 0; j < 64; j++){
+      history[i][j] /= 8;
+    }
+  }
+
+  //Late move reductions grow with the log of both the depth left and the move's place in the list
+  for(int d = 0; d < MAX_PLY; d++){
+    for(int k = 0; k < 64; k++){
+      reductions[d][k] = (d == 0 || k == 0) ? 0 :
+        int(options.lateMoveReductionsBase + log(double(d)) * log(double(k)) / options.lateMoveReductionsDivisor);
+    }
+  }
+
+  //Everything from the last search is thrown away. Only positions since the last capture or pawn move
+  //can repeat, so only those game keys are kept, followed by room for the deepest path. The frames always fit,
+  //see the static_assert above the constructor, and the game keys are cut to the room left after them, one less
+  //than the bytes allow in case the start has to be moved up to line the keys up
+  arena.reset();
+  frames = arena.allocate<SearchFrame>(MAX_PLY + 1);
+  int room = int((arena.capacity - arena.used) / sizeof(uint64_t)) - (MAX_PLY + 2) - 1;
+  int kept = max(0, min(min(int(gameKeys.size()), root.halfmove_clock), room));
+  positionKeys = arena.allocate<uint64_t>(kept + MAX_PLY + 2);
+  keyCount = 0;
+  for(size_t i = gameKeys.size() - kept; i < gameKeys.size(); i++){
+    positionKeys[keyCount++] = gameKeys[i];
+  }
+  positionKeys[keyCount++] = root.key;
+  for(int ply = 0; ply <= MAX_PLY; ply++){
+    frames[ply].killers[0] = NO_MOVE;
+    frames[ply].killers[1] = NO_MOVE;
+  }
+
+  MoveList & moves = frames[0].moves;
+  moves.count = 0;
+  root.generate_moves(moves, root.active_color);
+  pv[0] = moves.moves[0];
+  pvLength = 1;
+  score = 0;
+  lineCount = 0;
+  clock.set_root_moves(moves.count);
+  int wanted = max(1, min(min(options.multiPV, MAX_MULTI_PV), moves.count));
+
+  for(int depth = 1; depth <= maxDepth && !stopped; depth++){
+    //MultiPV: each line searches the root moves the lines before it did not take, so line k is the
+    //k-th best move. Everything below the root, and the transposition table, is shared between lines
+    int found = 0;
+    excludedCount = 0;
+    for(int line = 0; line < wanted && !stopped; line++){
+      //Start from this line's result in the last iteration, if it still has one to give
+      int lineScore = 0;
+      bool inherited = false;   //TRUE if lineScore is this line's last score, worth a window around it
+      pvLength = 0;
+      if(line < lineCount && !is_excluded(lines[line].moves[0])){
+        inherited = true;
+        for(int k = 0; k < lines[line].length; k++){
+          pv[k] = lines[line].moves[k];
+        }
+        pvLength = lines[line].length;
+        lineScore = lines[line].score;
+      }
+      for(int k = 0; pvLength == 0; k++){
+        if(!is_excluded(moves.moves[k])){
+          pv[0] = moves.moves[k];
+          pvLength = 1;
+        }
+      }
+
+      //Aspiration window: expect a score close to the last iteration's and search a narrow window around it,
+      //widening whichever side fails until the score lands inside
+      int delta = options.aspirationWindow;
+      int alpha = -INFINITE_SCORE;
+      int beta = INFINITE_SCORE;
+      if(options.aspiration && depth >= options.aspirationMinDepth && inherited &&
+         abs(lineScore) < MATE_SCORE - MAX_PLY){
+        alpha = lineScore - delta;
+        beta = lineScore + delta;
+      }
+      while(true){
+        int result = search_root(root, depth, alpha, beta);
+        if(stopped) break;
+        if(result <= alpha){
+          alpha = max(alpha - delta, -INFINITE_SCORE);
+        } else if(result >= beta){
+          beta = min(beta + delta, INFINITE_SCORE);
+        } else {
+          lineScore = result;
+          break;
+        }
+        delta *= 2;
+      }
+      //A stopped search still improves the best line if it found something better, but a later line
+      //cut short is left out
+      if(stopped && line > 0) break;
+      PVLine & result = iterationLines[line];
+      for(int k = 0; k < pvLength; k++){
+        result.moves[k] = pv[k];
+      }
+      result.length = pvLength;
+      result.score = (stopped ? (line < lineCount ? lines[line].score : score) : lineScore);
+      excluded[excludedCount++] = pv[0];
+      found++;
+    }
+
+    //Aspiration and pruning can leave later lines slightly out of order, so sort them by score
+    for(int i = 1; i < found; i++){
+      for(int j = i; j > 0 && iterationLines[j].score > iterationLines[j-1].score; j--){
+        swap(iterationLines[j], iterationLines[j-1]);
+      }
+    }
+    //A stopped iteration keeps the last finished results of the lines it did not get to,
+    //leaving out any whose move one of the new lines took
+    int total = found;
+    for(int i = found; i < lineCount; i++){
+      if(!is_excluded(lines[i].moves[0])){
+        lines[total++] = lines[i];
+      }
+    }
+    lineCount = total;
+    for(int i = 0; i < found; i++){
+      lines[i] = iterationLines[i];
+    }
+    for(int k = 0; k < lines[0].length; k++){
+      pv[k] = lines[0].moves[k];
+    }
+    pvLength = lines[0].length;
+    score = lines[0].score;
+
+    if(!stopped){
+      if(options.onIteration){
+        for(int i = 0; i < lineCount; i++){
+          SearchInfo info = {depth, i + 1, lines[i].score, nodes, clock.elapsed(), lines[i].moves, lines[i].length};
+          options.onIteration(info);
+        }
+      }
+      if(options.printIterations && log_enabled(LOG_INFO)){
+        for(int i = 0; i < lineCount; i++){
+          //Longest pv is MAX_PLY moves of at most five letters and a space
+          char pvText[MAX_PLY * 6 + 1];
+          int used = 0;
+          for(int k = 0; k < lines[i].length; k++){
+            used += snprintf(pvText + used, sizeof(pvText) - used, " %s", move_to_uci(lines[i].moves[k]).c_str());
+          }
+          pvText[used] = '\0';
+          if(wanted > 1){
+            log_printf(LOG_INFO, "depth %d multipv %d score %d nodes %ld pv%s", depth, i + 1, lines[i].score, nodes, pvText);
+          } else {
+            log_printf(LOG_INFO, "depth %d score %d nodes %ld pv%s", depth, lines[i].score, nodes, pvText);
+          }
+        }
+      }
+      clock.update(move_to_uci(pv[0]), score);
+    }
+    //No need to look deeper once a forced mate has been found, unless other lines are wanted too
+    if(wanted == 1 && (score > MATE_SCORE - MAX_PLY || score < -MATE_SCORE + MAX_PLY)) break;
+    if(clock.stop_iterating()) break;
+  }
+  if(traceBuffer != NULL) traceBuffer->flush();
+  return move_to_uci(pv[0]);
+}
+
+long Search::warm_up(gameState & root, double seconds){
+  if(!root.has_any_legal_move()) return 0;
+  TimeManager warmClock;
+  warmClock.start_fixed(seconds);
+  bool print = options.printIterations;
+  TraceWriter * trace = options.trace;
+  function<void(const SearchInfo &)> onIteration;
+  swap(onIteration, options.onIteration);
+  options.printIterations = false;
+  options.trace = NULL;
+  vector<uint64_t> noKeys;
+  best_move(root, noKeys, MAX_PLY - 1, warmClock);
+  options.printIterations = print;
+  options.trace = trace;
+  swap(onIteration, options.onIteration);
+  return nodes;
+}
+
+bool Search::is_excluded(Move move){
+  for(int k = 0; k < excludedCount; k++){
+    if(excluded[k] == move) return true;
+  }
+  return false;
+}
+
+int Search::root_node(gameState & root, int depth, int alpha, int beta){
+  SearchFrame & frame = frames[0];
+  frame.pvLength = 0;
+  for(int k = 0; k < pvLength; k++){
+    previousPV[k] = pv[k];
+  }
+  previousLength = pvLength;
+  followPV = true;
+  score_moves(root, frame, pv[0]);
+  int searched = 0;
+
+  for(int k = 0; k < frame.moves.count; k++){
+    Move move = pick_move(frame, k);
+    //Moves already taken by an earlier MultiPV line
+    if(is_excluded(move)) continue;
+    frame.moveIndex = k;
+    gameState next = root;
+    next.apply_move(move);
+    transpositionTable.prefetch(next.key);
+    positionKeys[keyCount++] = next.key;
+    int score;
+    //The first move gets the full window. The rest only have to show they are no better than it,
+    //which a null window proves cheaply, and are searched again if they turn out better
+    if(searched == 0){
+      score = -alpha_beta(next, depth - 1, -beta, -alpha, 1);
+    } else {
+      score = -alpha_beta(next, depth - 1, -alpha - 1, -alpha, 1);
+      if(score > alpha && score < beta && !stopped){
+        score = -alpha_beta(next, depth - 1, -beta, -alpha, 1);
+      }
+    }
+    searched++;
+    keyCount--;
+    if(stopped) break;
+    //The previous best move is searched first, so anything that beats it before time runs out is still an improvement
+    if(score > alpha){
+      alpha = score;
+      update_pv(0, move);
+      for(int i = 0; i < frame.pvLength; i++){
+        pv[i] = frame.pv[i];
+      }
+      pvLength = frame.pvLength;
+      if(score >= beta){
+        return beta;
+      }
+    }
+  }
+  return alpha;
+}
+
+void Search::update_pv(int ply, Move move){
+  SearchFrame & frame = frames[ply];
+  SearchFrame & child = frames[ply + 1];
+  frame.pv[0] = move;
+  for(int i = 0; i < child.pvLength; i++){
+    frame.pv[i + 1] = child.pv[i];
+  }
+  frame.pvLength = child.pvLength + 1;
+}
+
+int Search::alpha_beta_node(gameState & state, int depth, int alpha, int beta, int ply, bool allowNull){
+  nodes++;
+  SearchFrame & frame = frames[ply];
+  frame.pvLength = 0;
+  check_time();
+  if(stopped) return 0;
+  if(is_draw(state)){
+    frame.outcome = TRACE_TERMINAL;
+    //The fifty move rule does not apply when the last move was checkmate
+    if(state.halfmove_clock >= 100 && state.in_check() && !state.has_any_legal_move()){
+      return -MATE_SCORE + ply;
+    }
+    return 0;
+  }
+  //A drawn bitbase ending needs no search. The root still searches so there is a move to play
+  if(ply > 0 && probe_bitbase(state) == BITBASE_DRAW){
+    frame.outcome = TRACE_TERMINAL;
+    return 0;
+  }
+  if(depth <= 0 || ply >= MAX_PLY){
+    return quiescence(state, alpha, beta, ply);
+  }
+
+  bool inCheck = state.in_check();
+  bool pvNode = (beta - alpha > 1);  //Only nodes on the principal variation get a window wider than null
+
+  //Transposition table: an earlier search of this position at least as deep may already settle it.
+  //Principal variation nodes always search, so the line printed is the line that was searched
+  TTEntry entry;
+  Move ttMove = NO_MOVE;
+  if(transpositionTable.probe(state.key, entry)){
+    ttMove = entry.move;
+    int ttScore = score_from_tt(entry.score, ply);
+    if(!pvNode && entry.depth >= depth){
+      //Stays set only if one of these returns
+      frame.outcome = TRACE_TT_CUTOFF;
+      if(entry.bound() == BOUND_EXACT || (entry.bound() == BOUND_LOWER && ttScore >= beta)){
+        if(ttScore >= beta) return beta;
+        if(ttScore > alpha) return ttScore;
+      }
+      if((entry.bound() == BOUND_EXACT || entry.bound() == BOUND_UPPER) && ttScore <= alpha){
+        return alpha;
+      }
+      frame.outcome = TRACE_SEARCHED;
+    }
+  }
+
+  int staticEval = cached_evaluate(state);
+  frame.staticEval = staticEval;
+
+  //Reverse futility pruning: so far above beta that no quiet move should bring it back down
+  if(options.reverseFutility && !pvNode && !inCheck && depth <= options.reverseFutilityDepth &&
+     beta < MATE_SCORE - MAX_PLY && staticEval - options.reverseFutilityMargin * depth >= beta){
+    frame.outcome = TRACE_PRUNED;
+    return beta;
+  }
+
+  //Null move pruning: if passing the move still scores above beta, a real move almost certainly will too.
+  //Passing is only safe with pieces besides pawns, since pawn endgames are full of zugzwang
+  int pieces = non_pawn_pieces(state, state.active_color);
+  if(options.nullMove && allowNull && !pvNode && !inCheck && depth >= options.nullMoveMinDepth &&
+     staticEval >= beta && pieces > 0){
+    followPV = false;
+    frame.moveIndex = TRACE_NULL_INDEX;
+    int reduction = options.nullMoveReduction + depth / options.nullMoveDepthDivisor;
+    gameState next = state;
+    next.apply_null_move();
+    transpositionTable.prefetch(next.key);
+    positionKeys[keyCount++] = next.key;
+    int score = -alpha_beta(next, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+    keyCount--;
+    if(stopped) return 0;
+    if(score >= beta){
+      //With only a few pieces left zugzwang is still possible, so confirm with a reduced search
+      //that does not pass before trusting the cutoff
+      if(pieces > options.nullVerifyMaxPieces){
+        frame.outcome = TRACE_PRUNED;
+        return beta;
+      }
+      score = alpha_beta(state, depth - 1 - reduction, beta - 1, beta, ply, false);
+      if(stopped) return 0;
+      if(score >= beta){
+        frame.outcome = TRACE_PRUNED;
+        return beta;
+      }
+    }
+  }
+
+  frame.moves.count = 0;
+  state.generate_moves(frame.moves, state.active_color);
+  //No moves is checkmate if in check, stalemate if not
+  if(frame.moves.count == 0){
+    frame.outcome = TRACE_TERMINAL;
+    return inCheck ? -MATE_SCORE + ply : 0;
+  }
+  //While on the path of the last iteration's principal variation, its move is searched first,
+  //otherwise the best move from the transposition table
+  Move first = ttMove;
+  if(followPV && ply < previousLength){
+    first = previousPV[ply];
+  }
+  score_moves(state, frame, first);
+
+  //Futility pruning: too far below alpha for a quiet move to raise the score near the leaves
+  bool futile = options.futility && !inCheck && depth <= options.futilityDepth &&
+                alpha > -MATE_SCORE + MAX_PLY && staticEval + options.futilityMargin * depth <= alpha;
+  int quietMoves = 0;  //Quiet moves searched so far
+  int searched = 0;    //Moves searched so far
+  int originalAlpha = alpha;
+  Move bestMove = NO_MOVE;
+
+  for(int k = 0; k < frame.moves.count; k++){
+    Move move = pick_move(frame, k);
+    bool quiet = !state.is_tactical(move);
+    bool givesCheck = state.gives_check(move);
+    bool prunable = quiet && !givesCheck && !inCheck && k > 0;
+
+    if(prunable && futile){
+      continue;
+    }
+    //Late move pruning: with good ordering, quiet moves this late almost never matter near the leaves
+    if(prunable && options.lateMovePruning && depth <= options.lateMovePruningDepth &&
+       quietMoves >= options.lateMovePruningBase + depth * depth){
+      continue;
+    }
+    if(quiet) quietMoves++;
+    frame.moveIndex = k;
+
+    gameState next = state;
+    next.apply_move(move);
+    transpositionTable.prefetch(next.key);
+    positionKeys[keyCount++] = next.key;
+    int score;
+    //Late move reductions: search late quiet moves shallower with a null window, and only search
+    //them again at full depth if they turn out better than alpha
+    int reduction = 0;
+    if(prunable && options.lateMoveReductions && searched > 0 && depth >= options.lateMoveReductionsMinDepth &&
+       k >= options.lateMoveReductionsMinIndex){
+      reduction = reductions[min(depth, MAX_PLY - 1)][min(k, 63)];
+      //Moves that have caused cutoffs elsewhere are reduced less
+      reduction -= history[move_from(move)][move_to(move)] / options.lateMoveReductionsHistoryDivisor;
+      if(pvNode) reduction--;
+      reduction = max(0, min(reduction, depth - 2));
+    }
+    //Principal variation search: the first move gets the full window, the rest a null window,
+    //reduced if late, and are searched again at full depth and width only if they beat alpha
+    if(searched == 0){
+      score = -alpha_beta(next, depth - 1, -beta, -alpha, ply + 1);
+      followPV = false;
+    } else {
+      score = -alpha_beta(next, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+      if(score > alpha && reduction > 0 && !stopped){
+        score = -alpha_beta(next, depth - 1, -alpha - 1, -alpha, ply + 1);
+      }
+      if(score > alpha && score < beta && !stopped){
+        score = -alpha_beta(next, depth - 1, -beta, -alpha, ply + 1);
+      }
+    }
+    searched++;
+    keyCount--;
+    if(stopped) return 0;
+    if(score >= beta){
+      //Remember quiet moves that cause cutoffs so they are tried early in other positions,
+      //and at this ply as killers so they are tried early in the sibling positions
+      if(quiet){
+        if(frame.killers[0] != move){
+          frame.killers[1] = frame.killers[0];
+          frame.killers[0] = move;
+        }
+        int & entry = history[move_from(move)][move_to(move)];
+        entry += depth * depth;
+        //Keep history well below the capture scores in order_moves
+        if(entry > HISTORY_LIMIT){
+          for(int i = 0; i < 64; i++){
+            for(int j = 0; j < 64; j++){
+              history[i][j] /= 2;
+            }
+          }
+        }
+      }
+      transpositionTable.store(state.key, move, score_to_tt(beta, ply), depth, BOUND_LOWER);
+      return beta;
+    }
+    if(score > alpha){
+      alpha = score;
+      bestMove = move;
+      update_pv(ply, move);
+    }
+  }
+  //Nothing raising alpha only shows the score is at most alpha
+  transpositionTable.store(state.key, bestMove, score_to_tt(alpha, ply), depth,
+                           alpha > originalAlpha ? BOUND_EXACT : BOUND_UPPER);
+  return alpha;
+}
+
+int Search::quiescence_node(gameState & state, int alpha, int beta, int ply){
+  nodes++;
+  SearchFrame & frame = frames[ply];
+  frame.pvLength = 0;
+  check_time();
+  if(stopped) return 0;
+
+  //The side to move can usually do at least as well as the current evaluation by not taking anything
+  int standPat = cached_evaluate(state);
+  frame.staticEval = standPat;
+  if(standPat >= beta || ply >= MAX_PLY) return standPat;
+  if(standPat > alpha) alpha = standPat;
+
+  frame.moves.count = 0;
+  state.generate_moves(frame.moves, state.active_color);
+  score_moves(state, frame, NO_MOVE);
+  for(int k = 0; k < frame.moves.count; k++){
+    Move move = pick_move(frame, k);
+    //Tactical moves are scored above every quiet move, so the first quiet move ends the captures
+    if(!state.is_tactical(move)) break;
+    frame.moveIndex = k;
+    gameState next = state;
+    next.apply_move(move);
+    transpositionTable.prefetch(next.key);
+    int score = -quiescence(next, -beta, -alpha, ply + 1);
+    if(stopped) return 0;
+    if(score >= beta) return beta;
+    if(score > alpha) alpha = score;
+  }
+  return alpha;
+}
+
+int Search::traced(gameState & state, int depth, int alpha, int beta, int ply, bool allowNull, int kind){
+  TraceRecord record;
+  record.key = state.key;
+  record.node = traceNodes++;
+  record.parent = TRACE_NO_PARENT;
+  record.alpha = alpha;
+  record.beta = beta;
+  record.unused = 0;
+  record.move = NO_MOVE;
+  record.stream = traceBuffer->stream;
+  record.search = traceSearches;
+  record.depth = int8_t(max(0, min(depth, 127)));
+  record.ply = uint8_t(ply);
+  record.moveIndex = TRACE_NO_INDEX;
+  record.flags = uint8_t(kind | (beta - alpha > 1 ? TRACE_PV : 0));
+  if(kind == TRACE_ROOT){
+    //A root searched again for the same line of the same iteration is an aspiration window that failed
+    int line = depth * MAX_MULTI_PV + excludedCount;
+    if(line == traceLastRoot) record.flags |= TRACE_RESEARCH;
+    traceLastRoot = line;
+    traceIteration = depth;
+  }
+  record.iteration = uint8_t(traceIteration);
+  if(traceTop > 0){
+    TraceOpen & parent = traceStack[traceTop - 1];
+    record.parent = parent.node;
+    parent.children++;
+    //A null move verification or a quiescence search under a node of the same ply is not reached by a move
+    if(parent.ply < ply){
+      int index = frames[parent.ply].moveIndex;
+      record.moveIndex = uint8_t(index);
+      if(index == TRACE_NULL_INDEX){
+        record.flags |= TRACE_NULL_MOVE;
+      } else {
+        record.move = frames[parent.ply].moves.moves[index];
+      }
+      if(index == parent.lastChild) record.flags |= TRACE_RESEARCH;
+      parent.lastChild = index;
+    }
+  }
+  TraceOpen & open = traceStack[traceTop++];
+  open.node = record.node;
+  open.ply = ply;
+  open.lastChild = -1;
+  open.children = 0;
+
+  //A verification or quiescence search at the same ply shares the frame, so the caller's notes are put back after
+  SearchFrame & frame = frames[ply];
+  int callerEval = frame.staticEval;
+  int callerOutcome = frame.outcome;
+  frame.staticEval = TRACE_NO_EVAL;
+  frame.outcome = TRACE_SEARCHED;
+  int score;
+  if(kind == TRACE_ROOT){
+    score = root_node(state, depth, alpha, beta);
+  } else if(kind == TRACE_QUIESCENCE){
+    score = quiescence_node(state, alpha, beta, ply);
+  } else {
+    score = alpha_beta_node(state, depth, alpha, beta, ply, allowNull);
+  }
+  traceTop--;
+
+  record.score = score;
+  record.eval = int16_t(max(-32767, min(32767, frame.staticEval)));
+  if(frame.staticEval == TRACE_NO_EVAL) record.eval = TRACE_NO_EVAL;
+  record.outcome = uint8_t(frame.outcome);
+  if(frame.outcome == TRACE_SEARCHED){
+    record.outcome = uint8_t(score <= alpha ? TRACE_FAIL_LOW : (score >= beta ? TRACE_FAIL_HIGH : TRACE_EXACT));
+  }
+  //Moves are searched one at a time, so the child that failed high is the last one entered
+  record.bestIndex = (record.outcome == TRACE_FAIL_HIGH && open.lastChild >= 0 ? uint8_t(open.lastChild) : TRACE_NO_INDEX);
+  record.children = uint8_t(min(open.children, 255));
+  if(stopped) record.flags |= TRACE_STOPPED;
+  frame.staticEval = callerEval;
+  frame.outcome = callerOutcome;
+  traceBuffer->add(record);
+  return score;
+}
+
+bool Search::is_draw(gameState & state){
+  if(state.halfmove_clock >= 100){
+    return true;
+  }
+  //The same position can only come back with the same color to move, so check every second position,
+  //stopping at the last capture or pawn move
+  int current = keyCount - 1;
+  int oldest = current - state.halfmove_clock;
+  for(int i = current - 4; i >= 0 && i >= oldest; i -= 2){
+    if(positionKeys[i] == state.key){
+      return true;
+    }
+  }
+  return false;
+}
+
+int Search::cached_evaluate(gameState & state){
+  int score;
+  if(evalCache.probe(state.key, score)){
+    return score;
+  }
+  score = evaluate(state, state.active_color, pawnTable);
+  evalCache.store(state.key, score);
+  return score;
+}
+
+void Search::score_moves(gameState & state, SearchFrame & frame, Move first){
+  for(int k = 0; k < frame.moves.count; k++){
+    Move move = frame.moves.moves[k];
+    int from = move_from(move);
+    int to = move_to(move);
+    int score;
+    if(move == first){
+      score = INFINITE_SCORE;
+    } else if(state.is_tactical(move)){
+      //Most valuable victim first, least valuable attacker breaks ties. Above every history score
+      char victim = state.gameBoard[to/8][to%8];
+      char attacker = state.gameBoard[from/8][from%8];
+      score = INFINITE_SCORE/2 + piece_value(victim)*10 - piece_value(attacker)/10;
+      if(move_promotion(move) != PROMOTE_NONE) score += piece_value("-nbrq"[move_promotion(move)]);
+    } else if(move == frame.killers[0]){
+      score = INFINITE_SCORE/4;
+    } else if(move == frame.killers[1]){
+      score = INFINITE_SCORE/4 - 1;
+    } else {
+      score = history[from][to];
+    }
+    frame.scores[k] = score;
+  }
+}
+
+Move Search::pick_move(SearchFrame & frame, int k){
+  int best = k;
+  for(int i = k + 1; i < frame.moves.count; i++){
+    if(frame.scores[i] > frame.scores[best]){
+      best = i;
+    }
+  }
+  swap(frame.moves.moves[k], frame.moves.moves[best]);
+  swap(frame.scores[k], frame.scores[best]);
+  return frame.moves.moves[k];
+}
+
+void Search::check_time(){
+  if((nodes & 1023) == 0 && clock->hard_limit_reached()){
+    stopped = true;
+  }
+  if(options.nodeLimit > 0 && nodes >= options.nodeLimit){
+    stopped = true;
+  }
+}
@@ -0,0 +1,222 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+#include <functional>
+#include "game_logic.h"
+#include "evaluate.h"
+#include "eval_cache.h"
+#include "time_manager.h"
+#include "search_stack.h"
+#include "search_trace.h"
+#include "transposition_table.h"
+
+const int MATE_SCORE = 100000;       //Score for giving checkmate now, one less for each ply it takes
+const int INFINITE_SCORE = 1000000;  //Larger than any real score
+
+const int DEFAULT_PAWN_TABLE_MB = 1;
+const int DEFAULT_EVAL_CACHE_MB = 4;
+const int DEFAULT_TRANSPOSITION_TABLE_MB = 64;
+const int SEARCH_ARENA_KB = 256;     //Room for the search frames and the game's recent position keys
+const int MAX_MULTI_PV = 16;         //Most root moves MultiPV will rank
+const int TRACE_STACK_SIZE = 3 * (MAX_PLY + 1) + 1;  //A ply holds at most a node, its null move verification and a
+                                                     //quiescence search under either, plus the root
+
+//One line of a finished iteration, passed to SearchOptions::onIteration
+struct SearchInfo {
+  int depth;
+  int multiPV;         //1 for the best line, 2 for the second best and so on
+  int score;           //For the color to move at the root
+  long nodes;          //Searched so far in this search
+  double seconds;      //Since the search's clock was started
+  const Move * pv;     //Root move first, only valid during the call
+  int pvLength;
+};
+
+//Switches and parameters for the selective parts of the search. Depths are in plies, margins in centipawns
+struct SearchOptions {
+  bool nullMove = true;                  //Pass the move and prune if the position still fails high
+  int nullMoveMinDepth = 3;              //Least depth left to try a null move
+  int nullMoveReduction = 2;             //Null move search is this much shallower...
+  int nullMoveDepthDivisor = 4;          //...plus one more ply for every this many plies of depth
+  int nullVerifyMaxPieces = 2;           //With this few pieces besides pawns a null move cutoff is verified
+
+  bool lateMoveReductions = true;        //Search late quiet moves shallower
+  int lateMoveReductionsMinDepth = 3;
+  int lateMoveReductionsMinIndex = 3;    //Moves before this place in the ordered list are never reduced
+  double lateMoveReductionsBase = 0.75;  //reduction = base + log(depth) * log(move index) / divisor
+  double lateMoveReductionsDivisor = 2.25;
+  int lateMoveReductionsHistoryDivisor = 5000;  //One ply less reduction per this much history score
+
+  bool reverseFutility = true;           //Return beta when the evaluation is far above it
+  int reverseFutilityDepth = 6;
+  int reverseFutilityMargin = 120;       //per ply of depth left
+
+  bool futility = true;                  //Skip quiet moves when the evaluation is far below alpha
+  int futilityDepth = 3;
+  int futilityMargin = 150;              //per ply of depth left
+
+  bool lateMovePruning = true;           //Skip quiet moves past a count that grows with depth
+  int lateMovePruningDepth = 3;
+  int lateMovePruningBase = 4;           //quiet moves searched before pruning = base + depth * depth
+
+  bool aspiration = true;                //Search each iteration in a window around the last score
+  int aspirationMinDepth = 4;            //Shallower iterations use the full window
+  int aspirationWindow = 30;             //Starting half width, doubled each time the score falls outside
+
+  int multiPV = 1;                       //Number of best root moves to find, each with its own score and pv
+
+  long nodeLimit = 0;                    //Stop once this many nodes are searched, 0 for no limit
+  bool printIterations = true;           //Print the depth, score and pv of each finished iteration
+  function<void(const SearchInfo &)> onIteration;  //Called with each line of each finished iteration, if set.
+                                                   //Runs on the searching thread, so it should return quickly
+  TraceWriter * trace = NULL;            //Record every node of every search here, see search_trace.h. Off if NULL
+};
+
+//A traced node that has not returned yet
+struct TraceOpen {
+  uint32_t node;
+  int ply;
+  int lastChild;   //moveIndex of the last child entered, -1 before the first
+  int children;    //Child nodes entered
+};
+
+//One ranked root move with the line that follows it
+struct PVLine {
+  Move moves[MAX_PLY + 1];  //Root move first
+  int length;
+  int score;                //For the color to move at the root
+};
+
+//Time limited iterative deepening alpha-beta search with quiescence search and a history table.
+//A Search owns its caches and its arena, so one Search is used by one thread.
+//Once constructed it makes no heap allocations while searching.
+class Search{
+  public:
+    long nodes;            //Positions visited by the last call to best_move
+    int score;             //Score of the last finished iteration of best_move, for the color to move
+    SearchOptions options; //Which selective search techniques are used, and how hard they prune
+    Move pv[MAX_PLY + 1];  //Principal variation of the last finished iteration, best move first
+    int pvLength;          //Number of moves in pv
+    PVLine lines[MAX_MULTI_PV];  //Best options.multiPV root moves, best first. lines[0] is pv
+    int lineCount;               //Number of lines found
+    PawnTable pawnTable;   //Pawn structure evaluations
+    EvalCache evalCache;   //Static evaluations by position key, sized separately from the other tables
+    TranspositionTable transpositionTable;  //Search results by position key, kept between moves
+
+    //PRE : sizes must be at least 1
+    //POST: caches are allocated
+    //DESC: Create a search with its own pawn table, evaluation cache and transposition table
+    Search(int pawnTableMB = DEFAULT_PAWN_TABLE_MB, int evalCacheMB = DEFAULT_EVAL_CACHE_MB,
+           int transpositionTableMB = DEFAULT_TRANSPOSITION_TABLE_MB);
+    ~Search();
+
+    //PRE : root must be populated correctly and active_color must have at least one valid move.
+    //      gameKeys are the keys of the positions played before root, oldest first, or empty if unknown.
+    //POST: returns the best move found in UCI notation
+    //      clock must have been started
+    //DESC: Search one ply deeper each iteration until maxDepth is done or clock says to stop.
+    //      The best move of the last iteration is searched first in the next one
+    string best_move(gameState & root, const vector<uint64_t> & gameKeys, int maxDepth, TimeManager & clock);
+
+    //PRE : root must be populated correctly
+    //POST: returns the nodes searched. The tables hold what was learned about root
+    //DESC: Search root quietly for a fixed time before the game starts, so the first real move does not pay for
+    //      cold caches and untouched table pages
+    long warm_up(gameState & root, double seconds);
+
+  private:
+    int history[64][64];   //Score of quiet moves by from and to space, raised when a move causes a cutoff
+    int reductions[MAX_PLY][64];  //Late move reduction by depth left and move index, built from options
+    Arena arena;           //Holds frames and positionKeys, emptied at the start of each search
+    SearchFrame * frames;  //One frame per ply of the current search
+    Move previousPV[MAX_PLY + 1];  //pv at the start of the iteration, used to order moves along it
+    int previousLength;            //Number of moves in previousPV
+    bool followPV;                 //TRUE while the search is still on the path of previousPV
+    TimeManager * clock;   //Limits of the current search
+    bool stopped;          //TRUE once time has run out, every node returns right away after this
+    uint64_t * positionKeys;  //Keys of the game's recent positions followed by the ones on the current search path
+    int keyCount;             //Number of keys in positionKeys
+    Move excluded[MAX_MULTI_PV];           //Root moves taken by earlier lines of this iteration
+    int excludedCount;
+    PVLine iterationLines[MAX_MULTI_PV];   //Lines of the iteration being searched
+    TraceBuffer * traceBuffer;             //Where nodes are recorded while options.trace is set, NULL otherwise
+    uint32_t traceNodes;                   //Nodes numbered so far in this search's stream
+    uint16_t traceSearches;                //Traced calls of best_move so far
+    int traceIteration;                    //Depth of the iteration being traced
+    int traceLastRoot;                     //Iteration and MultiPV line of the last traced root, to spot aspiration retries
+    TraceOpen traceStack[TRACE_STACK_SIZE];  //Traced nodes entered and not yet returned, the innermost last
+    int traceTop;
+
+    //PRE : state must be the last position pushed after positionKeys' other entries
+    //POST: returns TRUE if state is a draw by repetition or by the fifty move rule
+    //DESC: Only looks back as far as the last capture or pawn move, since nothing before it can repeat.
+    //      A position repeated once inside the search is scored as a draw, since it could be repeated again
+    bool is_draw(gameState & state);
+
+    //PRE : frames[0].moves must be every valid move of root, pv must hold at least one move that is not excluded
+    //POST: returns the score of root between alpha and beta if it is inside them. pv is updated
+    //      whenever a move raises alpha, even if the search is stopped before finishing
+    //DESC: One iteration of principal variation search over the root moves that are not excluded
+    int search_root(gameState & root, int depth, int alpha, int beta){
+      if(traceBuffer != NULL) return traced(root, depth, alpha, beta, 0, false, TRACE_ROOT);
+      return root_node(root, depth, alpha, beta);
+    }
+    int root_node(gameState & root, int depth, int alpha, int beta);
+
+    //PRE : None
+    //POST: returns TRUE if move was taken by an earlier MultiPV line of this iteration
+    //DESC: Root moves in excluded are skipped by search_root
+    bool is_excluded(Move move);
+
+    //PRE : the search at ply + 1 must have just returned
+    //POST: the pv of frame ply is move followed by the pv of frame ply + 1
+    //DESC: Called when move becomes the best move at ply
+    void update_pv(int ply, Move move);
+
+    //PRE : state must be populated correctly
+    //POST: returns the score of state for the color to move, between alpha and beta if it is inside them
+    //DESC: Negamax principal variation search to depth plies, then quiescence search.
+    //      allowNull is FALSE right after a null move so two are never made in a row
+    int alpha_beta(gameState & state, int depth, int alpha, int beta, int ply, bool allowNull = true){
+      if(traceBuffer != NULL) return traced(state, depth, alpha, beta, ply, allowNull, 0);
+      return alpha_beta_node(state, depth, alpha, beta, ply, allowNull);
+    }
+    int alpha_beta_node(gameState & state, int depth, int alpha, int beta, int ply, bool allowNull);
+
+    //PRE : state must be populated correctly
+    //POST: returns the score of state once no captures are left to make
+    //DESC: Searches only captures and promotions so the evaluation is not taken in the middle of a trade
+    int quiescence(gameState & state, int alpha, int beta, int ply){
+      if(traceBuffer != NULL) return traced(state, 0, alpha, beta, ply, false, TRACE_QUIESCENCE);
+      return quiescence_node(state, alpha, beta, ply);
+    }
+    int quiescence_node(gameState & state, int alpha, int beta, int ply);
+
+    //PRE : traceBuffer must not be NULL
+    //POST: returns what root_node, quiescence_node or alpha_beta_node returns for kind TRACE_ROOT,
+    //      TRACE_QUIESCENCE or 0, and the node's record is added to traceBuffer
+    //DESC: Each of search_root, alpha_beta and quiescence runs its node through here while tracing, so an
+    //      untraced search pays one test of traceBuffer per node and nothing else
+    int traced(gameState & state, int depth, int alpha, int beta, int ply, bool allowNull, int kind);
+
+    //PRE : state must be populated correctly
+    //POST: returns evaluate() of state for the color to move
+    //DESC: Checks evalCache before running the full evaluation
+    int cached_evaluate(gameState & state);
+
+    //PRE : frame.moves must be valid moves for state
+    //POST: frame.scores holds the ordering score of each move
+    //DESC: Order is first, then captures by most valuable victim and least valuable attacker, then killers, then history
+    void score_moves(gameState & state, SearchFrame & frame, Move first);
+
+    //PRE : frame.scores must be filled in, moves before k must already have been picked
+    //POST: the best scored move from k on is swapped to k and returned
+    //DESC: One step of a selection sort, so moves after a cutoff are never sorted
+    Move pick_move(SearchFrame & frame, int k);
+
+    //PRE : None
+    //POST: stopped is set if the hard time limit has passed or the node limit is reached
+    //DESC: Polls the clock once every 1024 nodes, so checking costs almost nothing
+    void check_time();
+};
+
+#endif
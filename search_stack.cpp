@@ -0,0 +1,19 @@
+#include "search_stack.h"
+#include "memory_accounting.h"
+
+Arena::Arena(size_t bytes){
+  //new returns memory aligned for any plain type, so allocate only has to keep the offsets aligned
+  block = new char[bytes];
+  capacity = bytes;
+  used = 0;
+  memory_charge(MEMORY_SEARCH_STACKS, capacity);
+}
+
+Arena::~Arena(){
+  delete[] block;
+  memory_charge(MEMORY_SEARCH_STACKS, -(long long)capacity);
+}
+
+void Arena::reset(){
+  used = 0;
+}
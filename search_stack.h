@@ -0,0 +1,60 @@
+#ifndef SEARCH_STACK_H
+#define SEARCH_STACK_H
+#include <cstddef>
+#include <cstdint>
+#include "move.h"
+
+const int MAX_PLY = 64;  //Deepest the search will ever go, including quiescence
+
+//Everything the search keeps for one ply. One frame per ply is handed out at the start of a search,
+//so generating and ordering moves never allocates
+struct SearchFrame {
+  MoveList moves;             //Valid moves of the position at this ply
+  int scores[MAX_MOVES];      //Ordering score of each move in moves
+  Move pv[MAX_PLY + 1];       //Best line found from this ply, best move first
+  int pvLength;               //Number of moves in pv
+  Move killers[2];            //Last two quiet moves that caused a cutoff at this ply, newest first
+  int staticEval;             //Evaluation of the position before any move is searched
+  int moveIndex;              //Place in moves of the move being searched, TRACE_NULL_INDEX while passing. Read by the trace
+  int outcome;                //TraceOutcome of a node that returns without searching its moves. Read by the trace
+};
+
+//Bump allocator over one block allocated up front. Everything in it is thrown away at once by reset,
+//so a search can take what it needs without touching the heap. Each thread's Search has its own
+class Arena{
+  public:
+    //PRE : bytes must be at least 1
+    //POST: the block is allocated and empty
+    //DESC: Create an arena, this is the only allocation it ever makes
+    Arena(size_t bytes);
+    ~Arena();
+
+    //PRE : None
+    //POST: returns room for count objects of type T, or NULL if the arena is full
+    //DESC: The objects are not constructed, so T must be plain data
+    template <class T>
+    T * allocate(size_t count){
+      size_t start = (used + alignof(T) - 1) / alignof(T) * alignof(T);
+      if(start + count * sizeof(T) > capacity){
+        return NULL;
+      }
+      used = start + count * sizeof(T);
+      return reinterpret_cast<T *>(block + start);
+    }
+
+    //PRE : nothing allocated from the arena may be used after this
+    //POST: the arena is empty
+    //DESC: Called at the start of each search
+    void reset();
+
+    size_t used;      //Bytes handed out since the last reset
+    size_t capacity;  //Size of the block
+
+  private:
+    char * block;
+
+    Arena(const Arena &);
+    Arena & operator=(const Arena &);
+};
+
+#endif
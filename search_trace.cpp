@@ -0,0 +1,50 @@
+#include "search_trace.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include "memory_accounting.h"
+
+TraceWriter::TraceWriter(const string & path) : records(0), lost(0), offset(0), streams(0){
+  fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+TraceWriter::~TraceWriter(){
+  if(fd >= 0){
+    close(fd);
+  }
+}
+
+bool TraceWriter::write(const TraceRecord * batch, int count){
+  size_t bytes = size_t(count) * sizeof(TraceRecord);
+  uint64_t start = offset.fetch_add(bytes);
+  const char * data = reinterpret_cast<const char *>(batch);
+  //pwrite may write less than asked, so keep going until the whole batch is out
+  size_t done = 0;
+  while(done < bytes){
+    ssize_t written = pwrite(fd, data + done, bytes - done, start + done);
+    if(written <= 0) break;
+    done += written;
+  }
+  //Only whole records count as written
+  uint64_t whole = done / sizeof(TraceRecord);
+  records += whole;
+  lost += count - whole;
+  return done == bytes;
+}
+
+TraceBuffer::TraceBuffer(TraceWriter & writer) : writer(writer){
+  stream = writer.new_stream();
+  count = 0;
+  memory_charge(MEMORY_TRACE_BUFFERS, sizeof(TraceBuffer));
+}
+
+TraceBuffer::~TraceBuffer(){
+  flush();
+  memory_charge(MEMORY_TRACE_BUFFERS, -(long long)sizeof(TraceBuffer));
+}
+
+void TraceBuffer::flush(){
+  if(count > 0){
+    writer.write(records, count);
+    count = 0;
+  }
+}
@@ -0,0 +1,126 @@
+#ifndef SEARCH_TRACE_H
+#define SEARCH_TRACE_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "move.h"
+using namespace std;
+
+//How a traced node ended
+enum TraceOutcome {
+  TRACE_SEARCHED,     //Only while the node runs, replaced by one of the three below once it returns
+  TRACE_FAIL_LOW,     //Searched, score at or below alpha
+  TRACE_EXACT,        //Searched, score inside the window
+  TRACE_FAIL_HIGH,    //Searched, score at or above beta
+  TRACE_TT_CUTOFF,    //Settled by the transposition table
+  TRACE_PRUNED,       //Cut by reverse futility or a null move before any move was searched
+  TRACE_TERMINAL      //Draw, bitbase draw, checkmate or stalemate
+};
+
+//TraceRecord::flags
+enum {
+  TRACE_QUIESCENCE = 1,  //A quiescence node
+  TRACE_RESEARCH = 2,    //The same move from the same parent was already searched, with less depth or a narrower window
+  TRACE_NULL_MOVE = 4,   //Reached by passing the move
+  TRACE_PV = 8,          //Searched with a window wider than null
+  TRACE_ROOT = 16,       //One search_root call, an iteration or one of its aspiration windows
+  TRACE_STOPPED = 32     //Time or the node limit ran out inside the node, its score means nothing
+};
+
+const uint8_t TRACE_NO_INDEX = 255;     //moveIndex of a node with no move from a parent, bestIndex when nothing cut off
+const uint8_t TRACE_NULL_INDEX = 254;   //moveIndex of the null move
+const int16_t TRACE_NO_EVAL = -32768;   //eval of a node that never evaluated its position
+const uint32_t TRACE_NO_PARENT = 0xFFFFFFFF;
+
+//One node of a traced search, written when the node returns, so a node always comes after its children.
+//48 bytes with no padding so a trace file is a plain array. Node numbers count up from 0 in the order the
+//nodes were entered, separately for each stream, so together stream and node name a node
+struct TraceRecord {
+  uint64_t key;          //gameState::key of the node's position
+  uint32_t node;
+  uint32_t parent;       //node of the parent, TRACE_NO_PARENT for a root
+  int32_t alpha;         //Window the node was searched with, for the color to move
+  int32_t beta;
+  int32_t score;         //What the node returned
+  uint32_t unused;
+  int16_t eval;          //Static evaluation, or TRACE_NO_EVAL
+  Move move;             //Move from the parent, NO_MOVE for a root or a null move
+  uint16_t stream;       //Which buffer wrote it, one per searching thread
+  uint16_t search;       //Counts the stream's best_move calls
+  int8_t depth;          //Depth left, 0 in quiescence
+  uint8_t ply;
+  uint8_t moveIndex;     //Place of move in the parent's ordered list, TRACE_NULL_INDEX or TRACE_NO_INDEX
+  uint8_t bestIndex;     //moveIndex of the child that failed high, TRACE_NO_INDEX if none did
+  uint8_t children;      //Child nodes entered, re-searches included, at most 255
+  uint8_t outcome;       //TraceOutcome
+  uint8_t flags;         //TRACE_* flags
+  uint8_t iteration;     //Depth of the root iteration the node is part of
+};
+
+static_assert(sizeof(TraceRecord) == 48, "TraceRecord must be packed");
+
+const int TRACE_BUFFER_SIZE = 8192;  //Records a thread collects before writing them out
+
+//Trace file shared by every thread, written the same way as a TrainingWriter: each write reserves its
+//place with one atomic add and pwrites there, so one thread's records stay in order
+class TraceWriter{
+  public:
+    atomic<uint64_t> records;  //Records written so far
+    atomic<uint64_t> lost;     //Records a failed write left out. Their place in the file is zeros
+
+    //PRE : None
+    //POST: path is created or emptied, is_open says if it worked
+    TraceWriter(const string & path);
+    ~TraceWriter();
+
+    bool is_open() const { return fd >= 0; }
+
+    //PRE : None
+    //POST: returns a stream number no other caller has been given
+    uint16_t new_stream() { return uint16_t(streams++); }
+
+    //PRE : the file must be open
+    //POST: the records are in the file, after any this thread wrote before.
+    //      returns FALSE if the write failed part way, the records not written are counted in lost
+    //DESC: Append records from any thread
+    bool write(const TraceRecord * batch, int count);
+
+  private:
+    int fd;
+    atomic<uint64_t> offset;   //End of the space reserved so far
+    atomic<uint32_t> streams;  //Stream numbers handed out
+
+    TraceWriter(const TraceWriter &);
+    TraceWriter & operator=(const TraceWriter &);
+};
+
+//One searching thread's records, written out to a TraceWriter in large blocks
+class TraceBuffer{
+  public:
+    TraceWriter & writer;
+    uint16_t stream;       //This buffer's stream number in the file
+
+    TraceBuffer(TraceWriter & writer);
+    ~TraceBuffer();
+
+    //PRE : None
+    //POST: record is buffered, the buffer is written out first if it is full
+    void add(const TraceRecord & record){
+      if(count == TRACE_BUFFER_SIZE) flush();
+      records[count++] = record;
+    }
+
+    //PRE : None
+    //POST: every buffered record is written out
+    //DESC: Called when full and at the end of every search
+    void flush();
+
+  private:
+    TraceRecord records[TRACE_BUFFER_SIZE];
+    int count;
+
+    TraceBuffer(const TraceBuffer &);
+    TraceBuffer & operator=(const TraceBuffer &);
+};
+
+#endif
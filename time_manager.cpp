@@ -0,0 +1,73 @@
+#include "time_manager.h"
+#include <algorithm>
+
+TimeManager::TimeManager(){
+  start_fixed(1.0);
+}
+
+void TimeManager::start(double remainingSeconds, int movesPlayed){
+  startTime = chrono::steady_clock::now();
+  stopped = false;
+  double usable = max(remainingSeconds - options.overhead, 0.0);
+  int movesToGo = max(options.minMovesToGo, options.maxMovesToGo - movesPlayed);
+  softLimit = usable / movesToGo;
+  hardLimit = min(softLimit * options.hardFactor, usable * options.maxHardFraction);
+  deadline = startTime + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(hardLimit));
+  scale = 1.0;
+  rootScale = 1.0;
+  changes = 0;
+  lastBest = "";
+  lastScore = 0;
+  haveIteration = false;
+}
+
+void TimeManager::start_fixed(double seconds){
+  start(0, 0);
+  softLimit = seconds;
+  hardLimit = seconds;
+  deadline = startTime + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+}
+
+void TimeManager::set_root_moves(int count){
+  if(count <= 1){
+    rootScale = 0;
+  } else if(count <= options.fewMoves){
+    rootScale = options.fewMovesFactor;
+  } else {
+    rootScale = 1.0;
+  }
+}
+
+void TimeManager::update(const string & bestMove, int score){
+  //Best move stability: every change of mind means the position is unclear, so it earns more time
+  changes /= 2;
+  if(haveIteration && bestMove != lastBest){
+    changes += 1;
+  }
+  scale = 1.0 + options.instability * changes;
+  //Score swing: a falling score means trouble was just found, so look deeper before committing
+  if(haveIteration && score < lastScore - options.scoreDropMargin){
+    scale *= options.scoreDropFactor;
+  }
+  lastBest = bestMove;
+  lastScore = score;
+  haveIteration = true;
+}
+
+bool TimeManager::stop_iterating(){
+  //Each iteration takes a few times longer than the last, so one started late would be cut off by the hard limit
+  return elapsed() >= min(softLimit * scale * rootScale, hardLimit) * options.startFraction;
+}
+
+void TimeManager::stop(){
+  stopped = true;
+}
+
+bool TimeManager::hard_limit_reached(){
+  return stopped.load(memory_order_relaxed) || chrono::steady_clock::now() >= deadline;
+}
+
+double TimeManager::elapsed(){
+  chrono::duration<double> used = chrono::steady_clock::now() - startTime;
+  return used.count();
+}
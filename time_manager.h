@@ -0,0 +1,86 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+#include <atomic>
+#include <chrono>
+#include <string>
+using namespace std;
+
+//Parameters for splitting the clock between moves. Times are in seconds
+struct TimeOptions {
+  int maxMovesToGo = 50;          //Moves expected to be left in the game at the start
+  int minMovesToGo = 20;          //Never plan for fewer moves than this, the game might go long
+  double hardFactor = 4.0;        //Hard limit is this many soft limits...
+  double maxHardFraction = 0.25;  //...but never more than this much of the remaining clock
+  double overhead = 0.25;         //Kept back each move for network lag and other processes on the machine
+  double instability = 0.6;       //Soft limit grows by this much for each recent change of best move
+  int scoreDropMargin = 30;       //A score this many centipawns below the last iteration's is a swing...
+  double scoreDropFactor = 1.5;   //...and stretches the soft limit by this much
+  double fewMovesFactor = 0.6;    //Soft limit scale with only a few root moves to choose from
+  int fewMoves = 4;               //Number of root moves counted as few
+  double startFraction = 0.5;     //No new iteration past this much of the soft limit, it would rarely finish
+};
+
+//Decides how long a search may run. The soft limit is checked between iterations and is
+//stretched or cut as the search goes. The hard limit is a wall clock deadline the search polls
+//while it runs, so the move is always sent in time however busy the machine is.
+class TimeManager{
+  public:
+    TimeOptions options;
+    double softLimit;  //Seconds after which no new iteration is started
+    double hardLimit;  //Seconds after which the search stops wherever it is
+
+    TimeManager();
+
+    //PRE : remainingSeconds is the time left on the clock, movesPlayed is how many moves this player has made
+    //POST: the move's clock is started and the limits are set from the remaining time
+    //DESC: Called as soon as it is this player's turn
+    void start(double remainingSeconds, int movesPlayed);
+
+    //PRE : None
+    //POST: the move's clock is started, both limits are seconds
+    //DESC: Fixed time per move, for testing and tools that do not play on a clock
+    void start_fixed(double seconds);
+
+    //PRE : start must have been called
+    //POST: soft limit is scaled down when there are only a few moves to choose from
+    //DESC: With a single valid move there is nothing to think about, so the soft limit becomes 0
+    void set_root_moves(int count);
+
+    //PRE : start must have been called
+    //POST: the soft limit scale is updated from the iteration's result
+    //DESC: Called after each finished iteration with its best move and score
+    void update(const string & bestMove, int score);
+
+    //PRE : start must have been called
+    //POST: returns TRUE if another iteration should not be started
+    //DESC: Compares the time used to the stretched or cut soft limit
+    bool stop_iterating();
+
+    //PRE : None
+    //POST: hard_limit_reached returns TRUE until the clock is started again
+    //DESC: Ends the search using this clock early. Safe to call from any thread while it searches
+    void stop();
+
+    //PRE : start must have been called
+    //POST: returns TRUE once the hard limit has passed or stop has been called
+    //DESC: Called from inside the search every few thousand nodes, only reads the clock
+    bool hard_limit_reached();
+
+    //PRE : start must have been called
+    //POST: returns the seconds since start
+    //DESC: Time used on this move so far
+    double elapsed();
+
+  private:
+    chrono::steady_clock::time_point startTime;
+    chrono::steady_clock::time_point deadline;  //startTime + hardLimit, compared directly when polling
+    double scale;          //Current stretch of the soft limit
+    double rootScale;      //Cut for having few root moves
+    double changes;        //Recent best move changes, halved every iteration so old ones fade
+    string lastBest;       //Best move of the last iteration
+    int lastScore;         //Score of the last iteration
+    bool haveIteration;    //TRUE once update has been called for this move
+    atomic<bool> stopped;  //Set by stop, cleared by start
+};
+
+#endif
@@ -0,0 +1,188 @@
+//Self-play training data generator.
+//
+//Plays games against itself on every core with a fixed number of nodes per move, and writes each position
+//with the search score, best move and the game's result as a TrainingRecord (see training_data.h). Each thread collects
+//records in its own buffer and writes them in large blocks, reserving space in the file with an atomic add,
+//so the threads never wait on each other.
+//
+//Positions where the side to move is in check or the best move takes a piece, en passant included, or
+//promotes are left out, so the data is quiet positions ready for tools/texel_tuner.cpp. Each game starts with a few random moves for variety.
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/datagen.cpp $(ls *.cpp | grep -v ai.cpp) -o datagen
+//
+//Usage:
+//    datagen <output> [-games N] [-nodes N] [-threads T] [-random N] [-seed S]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include "search.h"
+#include "training_data.h"
+
+const int MAX_GAME_PLIES = 400;   //Games this long are called a draw
+const int DATAGEN_TT_MB = 16;     //Smaller than the engine's table, there is one per thread
+
+//Settings shared by every thread
+struct DatagenSettings {
+  long games;          //Games to play in total
+  long nodes;          //Node limit of each move's search
+  int randomPlies;     //Random moves at the start of each game
+  unsigned seed;
+};
+
+//PRE : state must be populated correctly
+//POST: returns TRUE if only the kings are left
+//DESC: Neither side can ever mate, so the game is a draw
+static bool only_kings(gameState & state){
+  for(int i = 0; i < 8; i++){
+    for(int j = 0; j < 8; j++){
+      if(state.gameBoard[i][j] != '-' && tolower(state.gameBoard[i][j]) != 'k') return false;
+    }
+  }
+  return true;
+}
+
+//PRE : keys must be the keys of the positions before state, oldest first
+//POST: returns TRUE if state has been seen twice before
+//DESC: Third time the same position comes up, the game is drawn
+static bool threefold(gameState & state, const vector<uint64_t> & keys){
+  int seen = 0;
+  int oldest = max(0, int(keys.size()) - state.halfmove_clock);
+  for(int i = int(keys.size()) - 2; i >= oldest; i -= 2){
+    if(keys[i] == state.key) seen++;
+  }
+  return seen >= 2;
+}
+
+//PRE : None
+//POST: game number next is played and its positions are added to buffer, repeated until every game is done
+//DESC: Run on each thread
+static void play_games(const DatagenSettings & settings, atomic<long> & nextGame, int threadIndex,
+                       TrainingWriter & writer){
+  Search search(DEFAULT_PAWN_TABLE_MB, DEFAULT_EVAL_CACHE_MB, DATAGEN_TT_MB);
+  search.options.nodeLimit = settings.nodes;
+  search.options.printIterations = false;
+  RecordBuffer * buffer = new RecordBuffer(writer);
+  mt19937_64 random(settings.seed + 7919 * threadIndex);
+  vector<TrainingRecord> positions;
+  vector<uint64_t> keys;
+  positions.reserve(MAX_GAME_PLIES);
+  keys.reserve(MAX_GAME_PLIES + 16);
+
+  for(long game = nextGame++; game < settings.games; game = nextGame++){
+    gameState state;
+    //Random opening, started over if it runs into a finished game
+    bool finished = true;
+    while(finished){
+      state.populate_board(STARTING_FEN);
+      positions.clear();
+      keys.clear();
+      finished = false;
+      for(int ply = 0; ply < settings.randomPlies && !finished; ply++){
+        MoveList moves;
+        state.generate_moves(moves, state.active_color);
+        if(moves.count == 0){
+          finished = true;
+        } else {
+          keys.push_back(state.key);
+          state.apply_move(moves.moves[random() % moves.count]);
+        }
+      }
+    }
+
+    int result = 0;
+    for(int ply = 0; ply < MAX_GAME_PLIES; ply++){
+      MoveList moves;
+      state.generate_moves(moves, state.active_color);
+      if(moves.count == 0){
+        //Checkmate is a loss for the color to move, stalemate a draw
+        if(state.in_check()) result = (state.active_color == "white" ? -1 : 1);
+        break;
+      }
+      if(state.halfmove_clock >= 100 || threefold(state, keys) || only_kings(state)){
+        break;
+      }
+
+      TimeManager clock;
+      clock.start_fixed(3600);
+      string best = search.best_move(state, keys, MAX_PLY - 1, clock);
+      int whiteScore = (state.active_color == "white" ? search.score : -search.score);
+      Move move = uci_to_move(best);
+      if(!state.in_check() && !state.is_tactical(move)){
+        TrainingRecord record;
+        encode_record(state, whiteScore, move, 0, record);
+        positions.push_back(record);
+      }
+      //A forced mate is as good as played out
+      if(abs(whiteScore) >= MATE_SCORE - MAX_PLY){
+        result = (whiteScore > 0 ? 1 : -1);
+        break;
+      }
+      keys.push_back(state.key);
+      state.apply_move(move);
+    }
+
+    for(size_t k = 0; k < positions.size(); k++){
+      positions[k].result = int8_t(result);
+      buffer->add(positions[k]);
+    }
+  }
+  buffer->flush();
+  delete buffer;
+}
+
+int main(int argc, char * argv[]){
+  if(argc < 2){
+    fprintf(stderr, "usage: %s <output> [-games N] [-nodes N] [-threads T] [-random N] [-seed S]\n", argv[0]);
+    return 1;
+  }
+  DatagenSettings settings;
+  settings.games = 1000;
+  settings.nodes = 5000;
+  settings.randomPlies = 8;
+  settings.seed = 1;
+  int threadCount = max(1u, thread::hardware_concurrency());
+  for(int a = 2; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-games") == 0) settings.games = atol(argv[a+1]);
+    else if(strcmp(argv[a], "-nodes") == 0) settings.nodes = atol(argv[a+1]);
+    else if(strcmp(argv[a], "-threads") == 0) threadCount = max(1, atoi(argv[a+1]));
+    else if(strcmp(argv[a], "-random") == 0) settings.randomPlies = atoi(argv[a+1]);
+    else if(strcmp(argv[a], "-seed") == 0) settings.seed = unsigned(atol(argv[a+1]));
+  }
+
+  TrainingWriter writer(argv[1]);
+  if(!writer.is_open()){
+    fprintf(stderr, "cannot write %s\n", argv[1]);
+    return 1;
+  }
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  atomic<long> nextGame(0);
+  vector<thread> threads;
+  for(int t = 0; t < threadCount; t++){
+    threads.push_back(thread(play_games, cref(settings), ref(nextGame), t, ref(writer)));
+  }
+  //Report progress until every game has been handed out
+  for(int tick = 1; nextGame < settings.games; tick++){
+    this_thread::sleep_for(chrono::seconds(1));
+    if(tick % 10 != 0) continue;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%ld/%ld games started, %llu positions written, %.0f positions/s\n", min(long(nextGame), settings.games),
+           settings.games, (unsigned long long)writer.records.load(), writer.records.load() / seconds);
+    fflush(stdout);
+  }
+  for(int t = 0; t < threadCount; t++){
+    threads[t].join();
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  printf("%llu positions written to %s in %.1fs\n", (unsigned long long)writer.records.load(), argv[1], seconds);
+  if(writer.lost > 0){
+    fprintf(stderr, "%llu positions could not be written, %s has gaps of zeros and should not be used\n",
+            (unsigned long long)writer.lost.load(), argv[1]);
+    return 1;
+  }
+  return 0;
+}
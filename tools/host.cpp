@@ -0,0 +1,149 @@
+//Multi-game engine host.
+//
+//Serves many games from one process through an EngineHost (see engine_host.h). Every game has its own
+//position, history and tables, all of them fit in one memory budget, and only -threads searches run at once.
+//Searches run in the background, so a slow game does not hold up the commands for the others.
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/host.cpp $(ls *.cpp | grep -v ai.cpp) -o host
+//
+//Usage:
+//    host [-memory MB] [-threads T] [-log FILE]
+//
+//The log, including the memory report of each status command, goes to standard error unless -log names a
+//file, so it never mixes with the answers on standard output.
+//
+//Commands, one per line on standard input:
+//    new <game> [MB]                             open a game, answers "ok <game> <MB>" or "error <game> ..."
+//    position <game> <fen> [history <moves>]     set the position, with the game's moves in UCI notation.
+//                                                The fen's move counters may be left out
+//    go <game> <seconds left>                    search in the background, answers "bestmove <game> <move>"
+//    close <game>                                close a game and give its memory back
+//    status                                      answers "status <games> <MB used>/<MB budget> MB" and logs
+//                                                the memory report
+//    quit                                        wait for the searches still running and exit
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include "engine_host.h"
+#include "logger.h"
+#include "memory_accounting.h"
+
+//A game and the thread searching it, if any
+struct HostedGame {
+  GameContext * game;
+  thread worker;
+};
+
+static mutex outputLock;
+
+//PRE : None
+//POST: line is written to standard output
+//DESC: Searches answer from their own threads, so lines are written whole
+static void answer(const string & line){
+  lock_guard<mutex> guard(outputLock);
+  printf("%s\n", line.c_str());
+  fflush(stdout);
+}
+
+//PRE : None
+//POST: the game's search, if there is one, has finished
+//DESC: Commands for a game wait for its last search so a position never changes while it is searched
+static void wait_for(HostedGame & hosted){
+  if(hosted.worker.joinable()) hosted.worker.join();
+}
+
+int main(int argc, char * argv[]){
+  int memoryMB = DEFAULT_HOST_MEMORY_MB;
+  int threads = max(1u, thread::hardware_concurrency());
+  string logPath = "/dev/stderr";
+  for(int a = 1; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-memory") == 0) memoryMB = max(1, atoi(argv[a+1]));
+    else if(strcmp(argv[a], "-threads") == 0) threads = max(1, atoi(argv[a+1]));
+    else if(strcmp(argv[a], "-log") == 0) logPath = argv[a+1];
+  }
+  if(!log_open(logPath, LOG_INFO)){
+    fprintf(stderr, "cannot write %s\n", logPath.c_str());
+    return 1;
+  }
+
+  EngineHost host(memoryMB, threads);
+  map<string, HostedGame> games;
+  string line;
+  while(getline(cin, line)){
+    istringstream words(line);
+    string command, name;
+    words >> command >> name;
+    map<string, HostedGame>::iterator it = games.find(name);
+
+    if(command == "quit"){
+      break;
+    } else if(command == "status"){
+      ostringstream out;
+      out << "status " << host.game_count() << " " << host.memory_used() << "/" << memoryMB << " MB";
+      answer(out.str());
+      log_memory_report("status", memoryMB);
+    } else if(command == "new"){
+      int gameMB = DEFAULT_ENGINE_MEMORY_MB;
+      words >> gameMB;
+      if(it != games.end()){
+        answer("error " + name + " already open");
+        continue;
+      }
+      GameContext * game = host.open_game(gameMB);
+      if(game == NULL){
+        answer("error " + name + " over memory budget");
+        continue;
+      }
+      games[name].game = game;
+      answer("ok " + name + " " + to_string(game->engine.plan.memoryMB));
+    } else if(it == games.end()){
+      answer("error " + name + " not open");
+    } else if(command == "position"){
+      wait_for(it->second);
+      //Four to six fields of FEN, the move counters are often left out, then the history if there is one
+      string fen, field;
+      int fields = 0;
+      while(fields < 6 && words >> field && field != "history"){
+        fen += (fields == 0 ? "" : " ") + field;
+        fields++;
+      }
+      if(fields < 4){
+        answer("error " + name + " bad position");
+        continue;
+      }
+      //After six fields the history keyword, if there is one, has not been read yet
+      if(fields == 6 && !(words >> field)) field = "";
+      vector<string> history;
+      if(field == "history"){
+        while(words >> field) history.push_back(field);
+      }
+      it->second.game->set_position(fen, history);
+    } else if(command == "go"){
+      wait_for(it->second);
+      double seconds = 1;
+      words >> seconds;
+      GameContext * game = it->second.game;
+      if(!game->engine.position.has_any_legal_move()){
+        answer("error " + name + " no legal moves");
+        continue;
+      }
+      it->second.worker = thread([&host, game, name, seconds](){
+        answer("bestmove " + name + " " + host.think(*game, seconds));
+      });
+    } else if(command == "close"){
+      wait_for(it->second);
+      host.close_game(it->second.game);
+      games.erase(it);
+    } else {
+      answer("error " + name + " unknown command " + command);
+    }
+  }
+
+  for(map<string, HostedGame>::iterator it = games.begin(); it != games.end(); it++){
+    wait_for(it->second);
+  }
+  return 0;
+}
@@ -0,0 +1,328 @@
+//Microbenchmarks for the board primitives.
+//
+//Times populate_board, move generation as a whole and one piece type at a time, isKingCheck, copyBoard,
+//getKingPos and move_string over a fixed set of positions, and counts the heap allocations each one makes.
+//Perft only gives one number for all of them together, this shows which one got slower.
+//
+//Results are compared against a baseline file and any primitive slower than the threshold, or allocating more,
+//is reported as a regression and makes the exit status 1. Baselines are only good for the machine and compiler
+//they were made with, so write a new one with -write before comparing on a different machine.
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/microbench.cpp game_logic.cpp logger.cpp -o microbench
+//
+//Usage:
+//    microbench [-baseline FILE] [-threshold PERCENT] [-time SECONDS] [-write FILE]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include "game_logic.h"
+
+//Every allocation in the program goes through here so each benchmark can count its own
+static long allocations = 0;
+
+void * operator new(size_t size){
+  allocations++;
+  void * memory = malloc(size == 0 ? 1 : size);
+  if(memory == NULL) throw bad_alloc();
+  return memory;
+}
+
+void operator delete(void * memory) noexcept{
+  free(memory);
+}
+
+void operator delete(void * memory, size_t) noexcept{
+  free(memory);
+}
+
+//Positions every benchmark runs over: the opening, busy middlegames, castling and en passant, and endgames
+static const char * CORPUS[] = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+  "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+  "r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R b KQ - 0 9",
+  "8/8/4k3/8/2K5/8/3Q4/8 w - - 0 1",
+  "8/5pk1/6p1/8/3R4/6P1/5PK1/8 b - - 0 1",
+};
+static const int CORPUS_SIZE = sizeof(CORPUS) / sizeof(CORPUS[0]);
+
+static gameState corpus[CORPUS_SIZE];
+static volatile uint64_t sink;  //Results go here so the compiler cannot skip the work
+
+//Reaches the private generators of gameState, see the friend declaration in game_logic.h
+class MoveGenBenchmark{
+  public:
+    //PRE : state must be populated correctly
+    //POST: returns the number of pieces of type piece (lower case) the color to move has
+    //DESC: Runs that piece type's generator on each of them, the same way generate_moves does
+    static long piece_moves(gameState & state, char piece, MoveList & moves){
+      const string & color = state.active_color;
+      int p = piece_index(color == "white" ? char(toupper(piece)) : piece);
+      for(int k = 0; k < state.pieceCount[p]; k++){
+        int i = state.pieceSquares[p][k] / 8;
+        int j = state.pieceSquares[p][k] % 8;
+        switch(piece){
+          case 'p': state.get_pawn_moves(moves, color, i, j); break;
+          case 'n': state.get_knight_moves(moves, color, i, j); break;
+          case 'b': state.get_bishop_moves(moves, color, i, j); break;
+          case 'r': state.get_rook_moves(moves, color, i, j); break;
+          case 'q': state.get_queen_moves(moves, color, i, j); break;
+          case 'k': state.get_king_moves(moves, color, i, j); break;
+        }
+      }
+      return state.pieceCount[p];
+    }
+
+    //PRE : state must be populated correctly
+    //POST: returns 1, the castling and en passant generators are run once each
+    static long special_moves(gameState & state, MoveList & moves){
+      state.get_castling_moves(moves, state.active_color);
+      state.get_en_passant_moves(moves, state.active_color);
+      return 1;
+    }
+};
+
+//Each benchmark makes one pass over the corpus and returns the number of calls it made
+static long bench_populate_board(){
+  gameState state;
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    state.populate_board(CORPUS[k]);
+    sink += state.key;
+  }
+  return CORPUS_SIZE;
+}
+
+static long bench_get_valid_moves(){
+  vector<string> moves;
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    moves.clear();
+    corpus[k].get_valid_moves(moves, corpus[k].active_color);
+    sink += moves.size();
+  }
+  return CORPUS_SIZE;
+}
+
+static long bench_generate_moves(){
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    MoveList moves;
+    corpus[k].generate_moves(moves, corpus[k].active_color);
+    sink += moves.count;
+  }
+  return CORPUS_SIZE;
+}
+
+static long bench_piece(char piece){
+  long calls = 0;
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    MoveList moves;
+    moves.count = 0;
+    calls += MoveGenBenchmark::piece_moves(corpus[k], piece, moves);
+    sink += moves.count;
+  }
+  return calls;
+}
+
+static long bench_pawn_moves(){ return bench_piece('p'); }
+static long bench_knight_moves(){ return bench_piece('n'); }
+static long bench_bishop_moves(){ return bench_piece('b'); }
+static long bench_rook_moves(){ return bench_piece('r'); }
+static long bench_queen_moves(){ return bench_piece('q'); }
+static long bench_king_moves(){ return bench_piece('k'); }
+
+static long bench_castling_en_passant(){
+  long calls = 0;
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    MoveList moves;
+    moves.count = 0;
+    calls += MoveGenBenchmark::special_moves(corpus[k], moves);
+    sink += moves.count;
+  }
+  return calls;
+}
+
+static long bench_isKingCheck(){
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    int x = 0, y = 0;
+    getKingPos(corpus[k].gameBoard, corpus[k].active_color, x, y);
+    sink += isKingCheck(corpus[k].gameBoard, corpus[k].active_color, x, y);
+  }
+  return CORPUS_SIZE;
+}
+
+static long bench_copyBoard(){
+  char copy[8][8];
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    copyBoard(corpus[k].gameBoard, copy, corpus[k].gameBoard[0][0], 0, 0, 0, 0);
+    sink += copy[k % 8][k % 8];
+  }
+  return CORPUS_SIZE;
+}
+
+static long bench_getKingPos(){
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    int x = 0, y = 0;
+    getKingPos(corpus[k].gameBoard, corpus[k].active_color, x, y);
+    sink += x * 8 + y;
+  }
+  return CORPUS_SIZE;
+}
+
+static long bench_move_string(){
+  long calls = 0;
+  for(int from = 0; from < 64; from += 3){
+    for(int to = 0; to < 64; to += 5){
+      sink += move_string(from / 8, from % 8, to / 8, to % 8)[0];
+      calls++;
+    }
+  }
+  return calls;
+}
+
+struct Benchmark {
+  const char * name;
+  long (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+  {"populate_board", bench_populate_board},
+  {"get_valid_moves", bench_get_valid_moves},
+  {"generate_moves", bench_generate_moves},
+  {"get_pawn_moves", bench_pawn_moves},
+  {"get_knight_moves", bench_knight_moves},
+  {"get_bishop_moves", bench_bishop_moves},
+  {"get_rook_moves", bench_rook_moves},
+  {"get_queen_moves", bench_queen_moves},
+  {"get_king_moves", bench_king_moves},
+  {"get_castling_en_passant_moves", bench_castling_en_passant},
+  {"isKingCheck", bench_isKingCheck},
+  {"copyBoard", bench_copyBoard},
+  {"getKingPos", bench_getKingPos},
+  {"move_string", bench_move_string},
+};
+static const int BENCHMARK_COUNT = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+struct Result {
+  double nsPerOp;
+  double allocsPerOp;
+};
+
+const int MEASURE_ROUNDS = 5;
+
+//PRE : None
+//POST: returns the time and allocations of one call of benchmark
+//DESC: One pass is run first and thrown away so the corpus and code are in the caches. The time is the
+//      fastest of several rounds, since other work on the machine only ever makes a round slower
+static Result measure(const Benchmark & benchmark, double seconds){
+  benchmark.run();
+  Result result;
+  result.nsPerOp = 0;
+  result.allocsPerOp = 0;
+  for(int round = 0; round < MEASURE_ROUNDS; round++){
+    long ops = 0;
+    long startAllocations = allocations;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double elapsed = 0;
+    while(elapsed < seconds / MEASURE_ROUNDS){
+      for(int pass = 0; pass < 16; pass++){
+        ops += benchmark.run();
+      }
+      elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    double nsPerOp = elapsed * 1e9 / max(1L, ops);
+    if(round == 0 || nsPerOp < result.nsPerOp) result.nsPerOp = nsPerOp;
+    result.allocsPerOp = max(result.allocsPerOp, double(allocations - startAllocations) / max(1L, ops));
+  }
+  return result;
+}
+
+//PRE : text must be a baseline written by write_baseline
+//POST: returns TRUE and fills in result if name has an entry in text
+//DESC: Only reads the flat format this tool writes, not JSON in general
+static bool find_baseline(const string & text, const string & name, Result & result){
+  size_t at = text.find("\"" + name + "\"");
+  if(at == string::npos) return false;
+  size_t ns = text.find("\"ns_per_op\":", at);
+  size_t allocs = text.find("\"allocs_per_op\":", at);
+  if(ns == string::npos || allocs == string::npos) return false;
+  result.nsPerOp = atof(text.c_str() + ns + strlen("\"ns_per_op\":"));
+  result.allocsPerOp = atof(text.c_str() + allocs + strlen("\"allocs_per_op\":"));
+  return true;
+}
+
+//PRE : results must hold one entry per benchmark
+//POST: returns TRUE if path was written
+static bool write_baseline(const string & path, const Result results[]){
+  FILE * out = fopen(path.c_str(), "w");
+  if(out == NULL) return false;
+  fprintf(out, "{\n");
+  for(int b = 0; b < BENCHMARK_COUNT; b++){
+    fprintf(out, "  \"%s\": {\"ns_per_op\": %.2f, \"allocs_per_op\": %.2f}%s\n", BENCHMARKS[b].name,
+            results[b].nsPerOp, results[b].allocsPerOp, b + 1 < BENCHMARK_COUNT ? "," : "");
+  }
+  fprintf(out, "}\n");
+  fclose(out);
+  return true;
+}
+
+int main(int argc, char * argv[]){
+  string baselinePath = "tools/bench_baseline.json";
+  string writePath;
+  double threshold = 10;
+  double seconds = 0.5;
+  for(int a = 1; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-baseline") == 0) baselinePath = argv[a+1];
+    else if(strcmp(argv[a], "-threshold") == 0) threshold = atof(argv[a+1]);
+    else if(strcmp(argv[a], "-time") == 0) seconds = atof(argv[a+1]);
+    else if(strcmp(argv[a], "-write") == 0) writePath = argv[a+1];
+  }
+
+  for(int k = 0; k < CORPUS_SIZE; k++){
+    corpus[k].populate_board(CORPUS[k]);
+  }
+  string baseline;
+  ifstream in(baselinePath.c_str());
+  if(in){
+    baseline.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+  } else if(writePath.empty()){
+    printf("no baseline at %s, use -write to make one\n", baselinePath.c_str());
+  }
+
+  Result results[BENCHMARK_COUNT];
+  int regressions = 0;
+  printf("%-30s %10s %10s %12s %8s\n", "primitive", "ns/op", "allocs/op", "baseline ns", "change");
+  for(int b = 0; b < BENCHMARK_COUNT; b++){
+    results[b] = measure(BENCHMARKS[b], seconds);
+    printf("%-30s %10.2f %10.2f", BENCHMARKS[b].name, results[b].nsPerOp, results[b].allocsPerOp);
+    Result base;
+    if(find_baseline(baseline, BENCHMARKS[b].name, base)){
+      double change = (results[b].nsPerOp / max(0.01, base.nsPerOp) - 1) * 100;
+      bool slower = change > threshold;
+      bool allocating = results[b].allocsPerOp > base.allocsPerOp + 0.005;
+      printf(" %12.2f %+7.1f%%%s%s", base.nsPerOp, change, slower ? "  SLOWER" : "", allocating ? "  MORE ALLOCATIONS" : "");
+      if(slower || allocating) regressions++;
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  if(!writePath.empty()){
+    if(!write_baseline(writePath, results)){
+      fprintf(stderr, "cannot write %s\n", writePath.c_str());
+      return 1;
+    }
+    printf("baseline written to %s\n", writePath.c_str());
+  }
+  if(regressions > 0){
+    printf("%d regressions over %.0f%%\n", regressions, threshold);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,259 @@
+//PGN database ingestion.
+//
+//Turns a PGN database into an opening book (see opening_book.h), a training dataset of TrainingRecords
+//(see training_data.h), or both in one pass. The file is memory mapped and handed out to every core in
+//pieces of a few megabytes, each piece starting at a game boundary, so a database of tens of gigabytes is
+//read at the speed of the disk without ever being copied or split beforehand. Moves are read from SAN
+//against the legal moves of the position (see pgn.h).
+//
+//Book: for each position in the first -plies plies of each game, how often each move was played and how
+//those games ended for the side that played it. Each thread counts into its own table, the tables are
+//added together at the end, and moves played in fewer than -min-games games are left out.
+//
+//Dataset: every position from ply -skip on that is not in check and whose played move neither takes, en passant
+//included, nor promotes, with the game's result. The score is 0, the played move is the best move. Ready for
+//tools/texel_tuner.cpp.
+//
+//Games without a result are skipped. A game with a move that can not be read is used up to that move.
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/pgn_ingest.cpp pgn.cpp opening_book.cpp training_data.cpp packed_position.cpp game_logic.cpp logger.cpp memory_accounting.cpp -o pgn_ingest
+//
+//Usage:
+//    pgn_ingest <games.pgn> [-book FILE] [-data FILE] [-threads T] [-plies N] [-min-games N] [-skip N]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include "opening_book.h"
+#include "pgn.h"
+#include "training_data.h"
+
+const size_t CHUNK_BYTES = 8 * 1024 * 1024;  //Piece of the file a thread takes at a time
+
+//Settings shared by every thread
+struct IngestSettings {
+  bool book;           //TRUE to count book moves
+  int bookPlies;       //Plies of each game that go in the book
+  int skipPlies;       //Opening plies left out of the dataset
+};
+
+//A move in a position, the key of the book tables
+struct BookMove {
+  uint64_t key;
+  Move move;
+
+  bool operator==(const BookMove & other) const { return key == other.key && move == other.move; }
+};
+
+struct BookMoveHash {
+  size_t operator()(const BookMove & bookMove) const {
+    return size_t(bookMove.key ^ (bookMove.move * 0x9E3779B97F4A7C15ULL));
+  }
+};
+
+//Results of the games a book move was played in, from the side of the player who played it
+struct BookCounts {
+  uint32_t games;
+  uint32_t wins;
+  uint32_t draws;
+};
+
+typedef unordered_map<BookMove, BookCounts, BookMoveHash> BookTable;
+
+//What one thread did
+struct IngestTotals {
+  long games;          //Games used
+  long skipped;        //Games without a result
+  long incomplete;     //Games with a move that could not be read
+  long records;        //Dataset positions
+};
+
+//PRE : file to end must be a mapped PGN file
+//POST: pieces of the file are read until none are left, adding to book, writer and totals
+//DESC: Run on each thread. A piece's games are the ones whose first tag starts inside it, so every
+//      game is read by exactly one thread even when it runs past the end of the piece
+static void ingest_pieces(const char * file, const char * end, const IngestSettings & settings,
+                          atomic<size_t> & nextPiece, atomic<size_t> & bytesDone, BookTable & book,
+                          TrainingWriter * writer, IngestTotals & totals){
+  RecordBuffer * buffer = (writer != NULL ? new RecordBuffer(*writer) : NULL);
+  PgnGame game;
+  game.moves.reserve(512);
+  totals.games = totals.skipped = totals.incomplete = totals.records = 0;
+
+  for(size_t piece = nextPiece++; file + piece * CHUNK_BYTES < end; piece = nextPiece++){
+    const char * start = file + piece * CHUNK_BYTES;
+    const char * cursor = (piece == 0 ? file : find_pgn_game(start, end));
+    const char * stop = (size_t(end - start) <= CHUNK_BYTES ? end : find_pgn_game(start + CHUNK_BYTES, end));
+    while(cursor < stop){
+      cursor = read_pgn_game(cursor, end, game);
+      if(game.result == PGN_NO_RESULT){
+        totals.skipped++;
+        continue;
+      }
+      totals.games++;
+      if(!game.complete) totals.incomplete++;
+
+      gameState state;
+      state.populate_board(game.fen);
+      for(size_t ply = 0; ply < game.moves.size(); ply++){
+        Move move = game.moves[ply];
+        if(settings.book && int(ply) < settings.bookPlies){
+          BookMove bookMove = {state.key, move};
+          BookCounts & counts = book[bookMove];
+          int result = (state.active_color == "white" ? game.result : -game.result);
+          counts.games++;
+          if(result > 0) counts.wins++;
+          if(result == 0) counts.draws++;
+        }
+        if(buffer != NULL && int(ply) >= settings.skipPlies && !state.is_tactical(move) &&
+           !state.in_check()){
+          TrainingRecord record;
+          encode_record(state, 0, move, game.result, record);
+          buffer->add(record);
+          totals.records++;
+        }
+        state.apply_move(move);
+      }
+    }
+    bytesDone += min(CHUNK_BYTES, size_t(end - start));
+  }
+  if(buffer != NULL){
+    buffer->flush();
+    delete buffer;
+  }
+}
+
+//Book order: by key, then the most played move first
+static bool book_order(const BookEntry & a, const BookEntry & b){
+  if(a.key != b.key) return a.key < b.key;
+  if(a.games != b.games) return a.games > b.games;
+  return a.move < b.move;
+}
+
+int main(int argc, char * argv[]){
+  if(argc < 2){
+    fprintf(stderr, "usage: %s <games.pgn> [-book FILE] [-data FILE] [-threads T] [-plies N] [-min-games N] [-skip N]\n",
+            argv[0]);
+    return 1;
+  }
+  string bookPath, dataPath;
+  IngestSettings settings;
+  settings.bookPlies = 20;
+  settings.skipPlies = 16;
+  unsigned minGames = 3;
+  int threadCount = max(1u, thread::hardware_concurrency());
+  for(int a = 2; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-book") == 0) bookPath = argv[a+1];
+    else if(strcmp(argv[a], "-data") == 0) dataPath = argv[a+1];
+    else if(strcmp(argv[a], "-threads") == 0) threadCount = max(1, atoi(argv[a+1]));
+    else if(strcmp(argv[a], "-plies") == 0) settings.bookPlies = atoi(argv[a+1]);
+    else if(strcmp(argv[a], "-min-games") == 0) minGames = unsigned(max(1, atoi(argv[a+1])));
+    else if(strcmp(argv[a], "-skip") == 0) settings.skipPlies = atoi(argv[a+1]);
+  }
+  settings.book = !bookPath.empty();
+  if(bookPath.empty() && dataPath.empty()){
+    fprintf(stderr, "nothing to write, give -book and/or -data\n");
+    return 1;
+  }
+
+  int fd = open(argv[1], O_RDONLY);
+  struct stat info;
+  if(fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0){
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  size_t size = info.st_size;
+  const char * file = static_cast<const char *>(mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0));
+  if(file == MAP_FAILED){
+    fprintf(stderr, "cannot map %s\n", argv[1]);
+    return 1;
+  }
+  madvise(const_cast<char *>(file), size, MADV_SEQUENTIAL);
+
+  TrainingWriter * writer = NULL;
+  if(!dataPath.empty()){
+    writer = new TrainingWriter(dataPath);
+    if(!writer->is_open()){
+      fprintf(stderr, "cannot write %s\n", dataPath.c_str());
+      return 1;
+    }
+  }
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  atomic<size_t> nextPiece(0), bytesDone(0);
+  vector<BookTable> books(threadCount);
+  vector<IngestTotals> totals(threadCount);
+  vector<thread> threads;
+  for(int t = 0; t < threadCount; t++){
+    threads.push_back(thread(ingest_pieces, file, file + size, cref(settings), ref(nextPiece), ref(bytesDone),
+                             ref(books[t]), writer, ref(totals[t])));
+  }
+  //Report progress until every piece has been read
+  for(int tick = 1; bytesDone < size; tick++){
+    this_thread::sleep_for(chrono::milliseconds(100));
+    if(tick % 100 != 0) continue;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%.1f%% read, %.0f MB/s\n", 100.0 * bytesDone / size, bytesDone / seconds / (1024 * 1024));
+    fflush(stdout);
+  }
+  for(int t = 0; t < threadCount; t++){
+    threads[t].join();
+  }
+  munmap(const_cast<char *>(file), size);
+  close(fd);
+
+  IngestTotals all = {0, 0, 0, 0};
+  for(int t = 0; t < threadCount; t++){
+    all.games += totals[t].games;
+    all.skipped += totals[t].skipped;
+    all.incomplete += totals[t].incomplete;
+    all.records += totals[t].records;
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  printf("%ld games read in %.1fs (%.0f MB/s), %ld without a result skipped, %ld with an unreadable move\n",
+         all.games, seconds, size / seconds / (1024 * 1024), all.skipped, all.incomplete);
+
+  if(settings.book){
+    //Add every thread's table into the first, freeing each as it goes
+    for(int t = 1; t < threadCount; t++){
+      for(BookTable::const_iterator it = books[t].begin(); it != books[t].end(); it++){
+        BookCounts & counts = books[0][it->first];
+        counts.games += it->second.games;
+        counts.wins += it->second.wins;
+        counts.draws += it->second.draws;
+      }
+      BookTable().swap(books[t]);
+    }
+    vector<BookEntry> entries;
+    for(BookTable::const_iterator it = books[0].begin(); it != books[0].end(); it++){
+      if(it->second.games < minGames) continue;
+      BookEntry entry;
+      entry.key = it->first.key;
+      entry.move = it->first.move;
+      entry.unused = 0;
+      entry.games = it->second.games;
+      entry.wins = it->second.wins;
+      entry.draws = it->second.draws;
+      entries.push_back(entry);
+    }
+    sort(entries.begin(), entries.end(), book_order);
+    if(!write_book(bookPath, entries)){
+      fprintf(stderr, "cannot write %s\n", bookPath.c_str());
+      return 1;
+    }
+    printf("%zu book moves written to %s\n", entries.size(), bookPath.c_str());
+  }
+  if(writer != NULL){
+    printf("%llu positions written to %s\n", (unsigned long long)writer->records.load(), dataPath.c_str());
+    delete writer;
+  }
+  return 0;
+}
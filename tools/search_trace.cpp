@@ -0,0 +1,307 @@
+//Search tree traces.
+//
+//record: searches one position with SearchOptions::trace set, so every node of every iteration is written to a
+//trace file (see search_trace.h). Any program can do the same by pointing a Search's options.trace at a
+//TraceWriter, each searching thread writing its own stream into the one file.
+//
+//report: reads a trace file and prints what aggregate counters can not show:
+//  - cutoffs by move index: where in the ordered list the move that failed high was, by depth left, the
+//    measure of move ordering
+//  - re-searches: nodes spent on searches that were thrown away, late move reductions and null windows that
+//    had to be searched again and aspiration windows that failed, and how often the second search disagreed
+//  - hot subtrees: the positions whose subtrees took the most nodes, summed over every visit, with the moves
+//    from the root to the visit that took the most
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/search_trace.cpp $(ls *.cpp | grep -v ai.cpp) -o search_trace
+//
+//Usage:
+//    search_trace record <trace> [-fen FEN] [-depth N] [-seconds S]
+//    search_trace report <trace> [-top N] [-min-ply N]
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include "search.h"
+
+const int INDEX_BUCKETS = 9;    //Cutoffs at move index 0 to 7, then 8 and later together
+const int DEPTH_ROWS = 16;      //Depths shown separately, deeper ones count in the last row
+
+//A node's place in the file, stream in the high 32 bits
+static uint64_t node_id(uint16_t stream, uint32_t node){
+  return (uint64_t(stream) << 32) | node;
+}
+
+//What is known about a node whose record has not been read yet, built up from its children's records
+struct PendingNode {
+  uint64_t subtree = 0;     //Nodes under it so far
+  int lastIndex = -1;       //moveIndex of the last child read
+  int lastDepth = 0;
+  uint64_t lastSize = 0;    //Subtree of the last child read, with the child
+};
+
+//Nodes of searches that were done again, and how many of the second searches came out unlike the first
+struct ResearchTotals {
+  long count = 0;
+  uint64_t wasted = 0;      //Nodes of the searches done again
+  long reversed = 0;        //Re-searches that went the other way, or aspiration retries that failed again
+};
+
+//Every visit of one position
+struct HotPosition {
+  uint64_t nodes = 0;
+  long visits = 0;
+  int ply = 255;            //Lowest ply it was visited at
+  int depth = 0;            //Depth left at the visit that took the most nodes
+  uint64_t largest = 0;     //Nodes of that visit
+  uint64_t id = 0;          //and where it is
+};
+
+static int record_search(const char * path, int argc, char * argv[]){
+  string fen = STARTING_FEN;
+  int depth = 8;
+  double seconds = 0;
+  for(int a = 3; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-fen") == 0) fen = argv[a+1];
+    else if(strcmp(argv[a], "-depth") == 0) depth = max(1, min(atoi(argv[a+1]), MAX_PLY - 1));
+    else if(strcmp(argv[a], "-seconds") == 0) seconds = atof(argv[a+1]);
+  }
+  TraceWriter writer(path);
+  if(!writer.is_open()){
+    fprintf(stderr, "cannot write %s\n", path);
+    return 1;
+  }
+  gameState root;
+  root.populate_board(fen);
+  if(!root.has_any_legal_move()){
+    fprintf(stderr, "the side to move has no moves\n");
+    return 1;
+  }
+  Search search;
+  search.options.printIterations = false;
+  search.options.trace = &writer;
+  TimeManager clock;
+  clock.start_fixed(seconds > 0 ? seconds : 1e7);
+  vector<uint64_t> noKeys;
+  string best = search.best_move(root, noKeys, depth, clock);
+  printf("best move %s, score %d, %ld nodes, %llu records written to %s\n", best.c_str(), search.score,
+         search.nodes, (unsigned long long)writer.records.load(), path);
+  if(writer.lost > 0){
+    fprintf(stderr, "%llu records could not be written, %s has gaps of zeros and should not be used\n",
+            (unsigned long long)writer.lost.load(), path);
+    return 1;
+  }
+  return 0;
+}
+
+//Prints the moves from the root to the node id, using the records gathered in chain
+static void print_path(uint64_t id, unordered_map<uint64_t, TraceRecord> & chain){
+  vector<string> moves;
+  for(unordered_map<uint64_t, TraceRecord>::iterator it = chain.find(id); it != chain.end();
+      it = chain.find(node_id(it->second.stream, it->second.parent))){
+    const TraceRecord & record = it->second;
+    if(record.flags & TRACE_ROOT) break;
+    if(record.flags & TRACE_NULL_MOVE) moves.push_back("null");
+    else if(record.move != NO_MOVE) moves.push_back(move_to_uci(record.move));
+    if(record.parent == TRACE_NO_PARENT) break;
+  }
+  for(int k = int(moves.size()) - 1; k >= 0; k--){
+    printf(" %s", moves[k].c_str());
+  }
+}
+
+static void print_research(const char * name, const ResearchTotals & totals, uint64_t nodes, const char * reversed){
+  printf("  %-28s %10ld   %12llu nodes (%5.1f%%)   %5.1f%% %s\n", name, totals.count,
+         (unsigned long long)totals.wasted, nodes > 0 ? 100.0 * totals.wasted / nodes : 0.0,
+         totals.count > 0 ? 100.0 * totals.reversed / totals.count : 0.0, reversed);
+}
+
+static int report(const char * path, int argc, char * argv[]){
+  int top = 20;
+  int minPly = 2;
+  for(int a = 3; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-top") == 0) top = max(1, atoi(argv[a+1]));
+    else if(strcmp(argv[a], "-min-ply") == 0) minPly = max(1, atoi(argv[a+1]));
+  }
+  int fd = open(path, O_RDONLY);
+  struct stat info;
+  if(fd < 0 || fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TraceRecord)){
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+  size_t count = info.st_size / sizeof(TraceRecord);
+  const TraceRecord * records = static_cast<const TraceRecord *>(mmap(NULL, count * sizeof(TraceRecord), PROT_READ,
+                                                                       MAP_PRIVATE, fd, 0));
+  if(records == MAP_FAILED){
+    fprintf(stderr, "cannot map %s\n", path);
+    return 1;
+  }
+  madvise(const_cast<TraceRecord *>(records), count * sizeof(TraceRecord), MADV_SEQUENTIAL);
+
+  uint64_t nodes = 0, quiescenceNodes = 0, roots = 0, stoppedNodes = 0;
+  uint64_t outcomes[TRACE_TERMINAL + 1] = {0};
+  uint64_t cutoffs[DEPTH_ROWS + 1][INDEX_BUCKETS] = {{0}};  //Row 0 is quiescence
+  ResearchTotals reduced, widened, aspiration;
+  unordered_map<uint64_t, PendingNode> pending;
+  unordered_map<uint16_t, uint64_t> lastRoot;               //Nodes of each stream's last root
+  unordered_map<uint64_t, HotPosition> hot;
+  unordered_set<uint32_t> streams;
+
+  //Children always come before their parent, so a node's subtree is complete when its own record is read
+  for(size_t r = 0; r < count; r++){
+    const TraceRecord & record = records[r];
+    uint64_t id = node_id(record.stream, record.node);
+    streams.insert(record.stream);
+    uint64_t size = 1;
+    unordered_map<uint64_t, PendingNode>::iterator it = pending.find(id);
+    if(it != pending.end()){
+      size += it->second.subtree;
+      pending.erase(it);
+    }
+    if(record.flags & TRACE_STOPPED) stoppedNodes++;
+
+    if(record.flags & TRACE_ROOT){
+      roots++;
+      if(record.flags & TRACE_RESEARCH){
+        aspiration.count++;
+        aspiration.wasted += lastRoot[record.stream];
+        if(record.outcome != TRACE_EXACT) aspiration.reversed++;
+      }
+      lastRoot[record.stream] = size;
+      continue;
+    }
+    nodes++;
+    bool quiescent = (record.flags & TRACE_QUIESCENCE) != 0;
+    if(quiescent) quiescenceNodes++;
+    else if(record.outcome <= TRACE_TERMINAL) outcomes[record.outcome]++;
+    if(record.outcome == TRACE_FAIL_HIGH && record.bestIndex != TRACE_NO_INDEX && record.bestIndex != TRACE_NULL_INDEX){
+      int row = (quiescent ? 0 : min(max(int(record.depth), 1), DEPTH_ROWS));
+      cutoffs[row][min(int(record.bestIndex), INDEX_BUCKETS - 1)]++;
+    }
+
+    PendingNode & parent = pending[node_id(record.stream, record.parent)];
+    //A re-search throws away the search of the same move just before it. From the parent's side the first search
+    //beat alpha, so the second went the other way if it fails high here, which is the parent failing low
+    if((record.flags & TRACE_RESEARCH) && record.moveIndex == parent.lastIndex){
+      ResearchTotals & totals = (parent.lastDepth < record.depth ? reduced : widened);
+      totals.count++;
+      totals.wasted += parent.lastSize;
+      if(record.outcome == TRACE_FAIL_HIGH) totals.reversed++;
+    }
+    parent.subtree += size;
+    parent.lastIndex = record.moveIndex;
+    parent.lastDepth = record.depth;
+    parent.lastSize = size;
+
+    if(record.ply >= minPly){
+      HotPosition & position = hot[record.key];
+      position.nodes += size;
+      position.visits++;
+      position.ply = min(position.ply, int(record.ply));
+      if(size > position.largest){
+        position.largest = size;
+        position.depth = record.depth;
+        position.id = id;
+      }
+    }
+  }
+
+  printf("%zu records, %zu streams, %llu roots, %llu nodes, %.1f%% in quiescence, %llu cut short by the clock\n",
+         count, streams.size(), (unsigned long long)roots, (unsigned long long)nodes,
+         nodes > 0 ? 100.0 * quiescenceNodes / nodes : 0.0, (unsigned long long)stoppedNodes);
+  uint64_t mainNodes = nodes - quiescenceNodes;
+  const char * OUTCOME_NAMES[TRACE_TERMINAL + 1] = {"", "fail low", "exact", "fail high", "tt cutoff", "pruned", "terminal"};
+  printf("\nmain search nodes by outcome\n");
+  for(int o = TRACE_FAIL_LOW; o <= TRACE_TERMINAL; o++){
+    printf("  %-10s %12llu %6.1f%%\n", OUTCOME_NAMES[o], (unsigned long long)outcomes[o],
+           mainNodes > 0 ? 100.0 * outcomes[o] / mainNodes : 0.0);
+  }
+
+  printf("\ncutoffs by move index, percent of the row's cutoffs\n  depth      cutoffs");
+  for(int i = 0; i < INDEX_BUCKETS; i++){
+    printf(i < INDEX_BUCKETS - 1 ? "     %d" : "    %d+", i);
+  }
+  printf("\n");
+  uint64_t allCutoffs[INDEX_BUCKETS] = {0};
+  for(int row = 0; row <= DEPTH_ROWS; row++){
+    uint64_t total = 0;
+    for(int i = 0; i < INDEX_BUCKETS; i++){
+      total += cutoffs[row][i];
+      if(row > 0) allCutoffs[i] += cutoffs[row][i];
+    }
+    if(total == 0) continue;
+    if(row == 0) printf("  quiesce");
+    else printf(row < DEPTH_ROWS ? "  %7d" : "  %6d+", row);
+    printf(" %12llu", (unsigned long long)total);
+    for(int i = 0; i < INDEX_BUCKETS; i++){
+      printf(" %5.1f", 100.0 * cutoffs[row][i] / total);
+    }
+    printf("\n");
+  }
+  uint64_t mainCutoffs = 0;
+  for(int i = 0; i < INDEX_BUCKETS; i++){
+    mainCutoffs += allCutoffs[i];
+  }
+  if(mainCutoffs > 0){
+    printf("  all main %12llu", (unsigned long long)mainCutoffs);
+    for(int i = 0; i < INDEX_BUCKETS; i++){
+      printf(" %5.1f", 100.0 * allCutoffs[i] / mainCutoffs);
+    }
+    printf("\n");
+  }
+
+  printf("\nre-searches: searches thrown away, nodes in them and share of all nodes\n");
+  print_research("late move reductions", reduced, nodes, "went the other way");
+  print_research("null windows", widened, nodes, "went the other way");
+  print_research("aspiration windows", aspiration, nodes, "failed again");
+
+  //Hottest positions, then one more pass to gather the records on the way to each one's largest visit.
+  //Parents come after their children, so each record found adds its parent to what is looked for
+  vector<pair<uint64_t, HotPosition> > hottest(hot.begin(), hot.end());
+  hot.clear();
+  size_t shown = min(size_t(top), hottest.size());
+  partial_sort(hottest.begin(), hottest.begin() + shown, hottest.end(),
+               [](const pair<uint64_t, HotPosition> & a, const pair<uint64_t, HotPosition> & b){
+                 return a.second.nodes > b.second.nodes;
+               });
+  hottest.resize(shown);
+  unordered_set<uint64_t> wanted;
+  for(size_t k = 0; k < shown; k++){
+    wanted.insert(hottest[k].second.id);
+  }
+  unordered_map<uint64_t, TraceRecord> chain;
+  for(size_t r = 0; r < count && !wanted.empty(); r++){
+    uint64_t id = node_id(records[r].stream, records[r].node);
+    if(wanted.erase(id) == 0) continue;
+    chain[id] = records[r];
+    if(records[r].parent != TRACE_NO_PARENT) wanted.insert(node_id(records[r].stream, records[r].parent));
+  }
+  printf("\nhot subtrees from ply %d: positions by nodes under them over every visit\n"
+         "         nodes  visits   ply  depth  key               moves to the largest visit\n", minPly);
+  for(size_t k = 0; k < shown; k++){
+    const HotPosition & position = hottest[k].second;
+    printf("  %12llu %7ld %5d %6d  %016llx ", (unsigned long long)position.nodes, position.visits, position.ply,
+           position.depth, (unsigned long long)hottest[k].first);
+    print_path(position.id, chain);
+    printf("\n");
+  }
+  munmap(const_cast<TraceRecord *>(records), count * sizeof(TraceRecord));
+  close(fd);
+  return 0;
+}
+
+int main(int argc, char * argv[]){
+  if(argc < 3 || (strcmp(argv[1], "record") != 0 && strcmp(argv[1], "report") != 0)){
+    fprintf(stderr, "usage: %s record <trace> [-fen FEN] [-depth N] [-seconds S]\n"
+                    "       %s report <trace> [-top N] [-min-ply N]\n", argv[0], argv[0]);
+    return 1;
+  }
+  if(strcmp(argv[1], "record") == 0) return record_search(argv[2], argc, argv);
+  return report(argv[2], argc, argv);
+}
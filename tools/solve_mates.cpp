@@ -0,0 +1,81 @@
+//Mate puzzle solver.
+//
+//Reads one puzzle per line as a FEN, optionally followed by "; mate N" for the most moves to look for, and
+//proves each one with the proof-number mate solver (see mate_solver.h). Prints the shortest mate found, or that
+//there is none within the limit, or that the node limit ran out first.
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/solve_mates.cpp game_logic.cpp logger.cpp mate_solver.cpp hash_memory.cpp memory_accounting.cpp -o solve_mates
+//
+//Usage:
+//    solve_mates <puzzles> [-moves N] [-nodes N] [-hash MB] [-checks]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "mate_solver.h"
+
+int main(int argc, char * argv[]){
+  if(argc < 2){
+    fprintf(stderr, "usage: %s <puzzles> [-moves N] [-nodes N] [-hash MB] [-checks]\n", argv[0]);
+    return 1;
+  }
+  int maxMoves = 10;
+  long nodeLimit = 10000000;
+  int hashMB = DEFAULT_MATE_HASH_MB;
+  bool checksOnly = false;
+  for(int a = 2; a < argc; a++){
+    if(strcmp(argv[a], "-checks") == 0) checksOnly = true;
+    else if(a + 1 >= argc) break;
+    else if(strcmp(argv[a], "-moves") == 0) maxMoves = atoi(argv[++a]);
+    else if(strcmp(argv[a], "-nodes") == 0) nodeLimit = atol(argv[++a]);
+    else if(strcmp(argv[a], "-hash") == 0) hashMB = max(1, atoi(argv[++a]));
+  }
+  maxMoves = max(1, min(maxMoves, MAX_PLY / 2));
+
+  ifstream in(argv[1]);
+  if(!in){
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  MateSolver solver(hashMB);
+  solver.checksOnly = checksOnly;
+  solver.nodeLimit = nodeLimit;
+  int solved = 0, puzzles = 0;
+  long totalNodes = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  string text;
+  while(getline(in, text)){
+    size_t semicolon = text.find(';');
+    string fen = text.substr(0, semicolon);
+    if(fen.find_first_not_of(" \t\r") == string::npos) continue;
+    int moves = maxMoves;
+    if(semicolon != string::npos){
+      size_t mate = text.find("mate", semicolon);
+      if(mate != string::npos) moves = max(1, min(atoi(text.c_str() + mate + 4), MAX_PLY / 2));
+    }
+
+    gameState root;
+    root.populate_board(fen);
+    MateStatus status = solver.solve(root, moves);
+    puzzles++;
+    totalNodes += solver.nodes;
+    if(status == MATE_FOUND){
+      solved++;
+      printf("mate in %d:", (solver.lineLength + 1) / 2);
+      for(int k = 0; k < solver.lineLength; k++){
+        printf(" %s", move_to_uci(solver.line[k]).c_str());
+      }
+      printf(" (%ld nodes)\n", solver.nodes);
+    } else if(status == MATE_NONE){
+      printf("no mate in %d (%ld nodes)\n", moves, solver.nodes);
+    } else {
+      printf("unknown, node limit reached (%ld nodes)\n", solver.nodes);
+    }
+    fflush(stdout);
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  printf("%d/%d mates in %.2fs, %ld nodes\n", solved, puzzles, seconds, totalNodes);
+  return 0;
+}
@@ -0,0 +1,398 @@
+//Texel tuner for the evaluation weights in eval_weights.cpp.
+//
+//Reads a dataset of quiet positions labeled with the result of the game they came from, one per line:
+//    <fen> [1.0]            result as a number from white's side, 1, 0.5 or 0
+//    <fen> "1-0";           or as a game result anywhere on the line, 1-0, 0-1 or 1/2-1/2
+//and finds the weights that make sigmoid(K * eval / 400) best predict the results.
+//The evaluation is a sum of weights times counts (see EvalTrace), so each position is reduced once to its
+//non-zero counts and every step after that is a sparse dot product.
+//
+//A file ending in .bin is read as TrainingRecords instead, as written by tools/datagen.cpp.
+//
+//The file is memory mapped and parsed by every core at once, the gradient is summed by every core into its
+//own array, and the weights are moved with Adam. The result is written in the format of eval_weights.cpp.
+//
+//Build from the repository root, see README.md:
+//    g++ -std=c++14 -O3 -march=native -pthread -I. tools/texel_tuner.cpp eval_weights.cpp evaluate.cpp bitbase.cpp pawn_table.cpp game_logic.cpp logger.cpp training_data.cpp packed_position.cpp memory_accounting.cpp -o texel_tuner
+//
+//Usage:
+//    texel_tuner <dataset> [-epochs N] [-rate R] [-threads T] [-k K] [-out eval_weights.cpp]
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "evaluate.h"
+#include "training_data.h"
+
+const int WEIGHT_COUNT = sizeof(EvalWeights) / sizeof(int);
+
+//One non-zero weight count of a position
+struct Feature {
+  uint16_t index;  //Index into EvalWeights seen as an int array
+  int16_t count;   //White minus black
+};
+
+//One labeled position, its features are features[first] to features[first + count - 1]
+struct TunePosition {
+  float result;    //1 white won, 0.5 draw, 0 black won
+  uint32_t first;
+  uint16_t count;
+};
+
+//Everything read from the dataset
+struct Dataset {
+  vector<TunePosition> positions;
+  vector<Feature> features;
+};
+
+//PRE : line must be a line of the dataset, not including the newline
+//POST: returns TRUE and sets result if the line has a result, FALSE if not
+//DESC: Finds "[x]" or a game result anywhere on the line
+static bool parse_result(const string & line, float & result){
+  size_t bracket = line.find('[');
+  if(bracket != string::npos){
+    result = float(atof(line.c_str() + bracket + 1));
+    return true;
+  }
+  if(line.find("1/2-1/2") != string::npos){ result = 0.5f; return true; }
+  if(line.find("1-0") != string::npos){ result = 1.0f; return true; }
+  if(line.find("0-1") != string::npos){ result = 0.0f; return true; }
+  return false;
+}
+
+//PRE : state must be populated correctly
+//POST: the position's non-zero weight counts and result are added to data
+//DESC: Reduce one labeled position to what the tuner needs
+static void add_position(gameState & state, float result, PawnTable & unused, Dataset & data){
+  EvalTrace trace;
+  memset(&trace, 0, sizeof(trace));
+  evaluate(state, "white", unused, &trace);
+  const int * counts = reinterpret_cast<const int *>(&trace.counts);
+
+  TunePosition position;
+  position.result = result;
+  position.first = data.features.size();
+  position.count = 0;
+  for(int i = 0; i < WEIGHT_COUNT; i++){
+    if(counts[i] != 0){
+      Feature feature = {uint16_t(i), int16_t(counts[i])};
+      data.features.push_back(feature);
+      position.count++;
+    }
+  }
+  data.positions.push_back(position);
+}
+
+//PRE : start to end must be whole records of the dataset
+//POST: every record is added to data
+//DESC: Run by each thread on its own piece of a mapped binary file
+static void parse_records(const TrainingRecord * start, const TrainingRecord * end, Dataset & data){
+  PawnTable unused(1);
+  for(const TrainingRecord * record = start; record < end; record++){
+    gameState state;
+    decode_record(*record, state);
+    add_position(state, (record->result + 1) / 2.0f, unused, data);
+  }
+}
+
+//PRE : start to end must be whole lines of the dataset
+//POST: every labeled position in the lines is added to data
+//DESC: Run by each thread on its own piece of the mapped file
+static void parse_lines(const char * start, const char * end, Dataset & data){
+  PawnTable unused(1);
+  const char * cursor = start;
+  while(cursor < end){
+    const char * newline = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+    if(newline == NULL) newline = end;
+    string line(cursor, newline);
+    cursor = newline + 1;
+
+    float result;
+    if(!parse_result(line, result)) continue;
+    //Only the board, color, castling and en passant fields are needed, the counters are dropped
+    stringstream fields(line);
+    string board, color, castling, enPassant;
+    if(!(fields >> board >> color >> castling >> enPassant)) continue;
+    if(count(board.begin(), board.end(), '/') != 7) continue;
+    gameState state;
+    state.populate_board(board + " " + color + " " + castling + " " + enPassant.substr(0, 2) + " 0 1");
+    add_position(state, result, unused, data);
+  }
+}
+
+//PRE : path must name a readable file
+//POST: returns every labeled position in the file
+//DESC: Maps the file and splits it into one piece per thread, at line breaks or between records
+static Dataset load_dataset(const char * path, int threadCount){
+  Dataset data;
+  int fd = open(path, O_RDONLY);
+  struct stat info;
+  if(fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0){
+    fprintf(stderr, "cannot read %s\n", path);
+    exit(1);
+  }
+  size_t size = info.st_size;
+  const char * file = static_cast<const char *>(mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0));
+  if(file == MAP_FAILED){
+    fprintf(stderr, "cannot map %s\n", path);
+    exit(1);
+  }
+  madvise(const_cast<char *>(file), size, MADV_SEQUENTIAL);
+  size_t length = strlen(path);
+  bool binary = (length > 4 && strcmp(path + length - 4, ".bin") == 0);
+
+  //Piece boundaries are moved forward to just past the next line break
+  vector<const char *> bounds(threadCount + 1);
+  bounds[0] = file;
+  bounds[threadCount] = file + size;
+  for(int t = 1; t < threadCount; t++){
+    if(binary){
+      bounds[t] = file + size / sizeof(TrainingRecord) / threadCount * t * sizeof(TrainingRecord);
+      continue;
+    }
+    const char * guess = file + size / threadCount * t;
+    const char * newline = static_cast<const char *>(memchr(guess, '\n', file + size - guess));
+    bounds[t] = (newline == NULL ? file + size : newline + 1);
+    bounds[t] = max(bounds[t], bounds[t-1]);
+  }
+  vector<Dataset> pieces(threadCount);
+  vector<thread> threads;
+  for(int t = 0; t < threadCount; t++){
+    if(binary){
+      //A partly written record at the end of the file is left out
+      const TrainingRecord * first = reinterpret_cast<const TrainingRecord *>(bounds[t]);
+      const TrainingRecord * last = first + (bounds[t+1] - bounds[t]) / sizeof(TrainingRecord);
+      threads.push_back(thread(parse_records, first, last, ref(pieces[t])));
+    } else {
+      threads.push_back(thread(parse_lines, bounds[t], bounds[t+1], ref(pieces[t])));
+    }
+  }
+  for(int t = 0; t < threadCount; t++){
+    threads[t].join();
+  }
+  munmap(const_cast<char *>(file), size);
+  close(fd);
+
+  //Join the pieces, moving each piece's feature offsets past the ones before it
+  for(int t = 0; t < threadCount; t++){
+    uint32_t offset = data.features.size();
+    for(size_t k = 0; k < pieces[t].positions.size(); k++){
+      pieces[t].positions[k].first += offset;
+      data.positions.push_back(pieces[t].positions[k]);
+    }
+    data.features.insert(data.features.end(), pieces[t].features.begin(), pieces[t].features.end());
+    vector<Feature>().swap(pieces[t].features);
+  }
+  return data;
+}
+
+static double sigmoid(double k, double eval){
+  return 1.0 / (1.0 + pow(10.0, -k * eval / 400.0));
+}
+
+static double position_eval(const Dataset & data, const TunePosition & position, const double * weights){
+  double eval = 0;
+  const Feature * feature = &data.features[position.first];
+  for(int i = 0; i < position.count; i++){
+    eval += weights[feature[i].index] * feature[i].count;
+  }
+  return eval;
+}
+
+//Runs work(thread, first, last) over the positions split evenly between threads
+template <class Work>
+static void parallel_for(const Dataset & data, int threadCount, Work work){
+  vector<thread> threads;
+  size_t per = (data.positions.size() + threadCount - 1) / threadCount;
+  for(int t = 0; t < threadCount; t++){
+    size_t first = min(data.positions.size(), per * t);
+    size_t last = min(data.positions.size(), first + per);
+    threads.push_back(thread(work, t, first, last));
+  }
+  for(int t = 0; t < threadCount; t++){
+    threads[t].join();
+  }
+}
+
+//PRE : None
+//POST: returns the mean squared error between the results and the predictions of weights
+//DESC: The number the tuner makes smaller
+static double total_error(const Dataset & data, const double * weights, double k, int threadCount){
+  vector<double> errors(threadCount, 0.0);
+  parallel_for(data, threadCount, [&](int t, size_t first, size_t last){
+    double sum = 0;
+    for(size_t p = first; p < last; p++){
+      double diff = data.positions[p].result - sigmoid(k, position_eval(data, data.positions[p], weights));
+      sum += diff * diff;
+    }
+    errors[t] = sum;
+  });
+  double sum = 0;
+  for(int t = 0; t < threadCount; t++) sum += errors[t];
+  return sum / data.positions.size();
+}
+
+//PRE : None
+//POST: gradient holds the derivative of total_error for each weight
+//DESC: Each thread sums into its own array, then the arrays are added together. Both loops over
+//      the weights are plain array adds that the compiler vectorizes
+static void compute_gradient(const Dataset & data, const double * weights, double k, int threadCount,
+                             double * gradient){
+  vector<vector<double> > partial(threadCount, vector<double>(WEIGHT_COUNT, 0.0));
+  parallel_for(data, threadCount, [&](int t, size_t first, size_t last){
+    double * sum = partial[t].data();
+    for(size_t p = first; p < last; p++){
+      const TunePosition & position = data.positions[p];
+      double s = sigmoid(k, position_eval(data, position, weights));
+      double scale = (s - position.result) * s * (1.0 - s);
+      const Feature * feature = &data.features[position.first];
+      for(int i = 0; i < position.count; i++){
+        sum[feature[i].index] += scale * feature[i].count;
+      }
+    }
+  });
+  double constant = 2.0 * k * log(10.0) / 400.0 / data.positions.size();
+  for(int i = 0; i < WEIGHT_COUNT; i++){
+    gradient[i] = 0;
+  }
+  for(int t = 0; t < threadCount; t++){
+    const double * sum = partial[t].data();
+    for(int i = 0; i < WEIGHT_COUNT; i++){
+      gradient[i] += sum[i];
+    }
+  }
+  for(int i = 0; i < WEIGHT_COUNT; i++){
+    gradient[i] *= constant;
+  }
+}
+
+//PRE : None
+//POST: returns the K that makes the current weights predict the results best
+//DESC: Ternary search, the error is smooth and has one minimum in K
+static double fit_k(const Dataset & data, const double * weights, int threadCount){
+  double low = 0.1;
+  double high = 3.0;
+  for(int step = 0; step < 40; step++){
+    double a = low + (high - low) / 3;
+    double b = high - (high - low) / 3;
+    if(total_error(data, weights, a, threadCount) < total_error(data, weights, b, threadCount)){
+      high = b;
+    } else {
+      low = a;
+    }
+  }
+  return (low + high) / 2;
+}
+
+//PRE : weights must be WEIGHT_COUNT long
+//POST: the rounded weights are written to path in the format of eval_weights.cpp
+//DESC: The output replaces eval_weights.cpp to use the tuned weights
+static void write_weights(const char * path, const double * weights){
+  EvalWeights rounded;
+  int * out = reinterpret_cast<int *>(&rounded);
+  for(int i = 0; i < WEIGHT_COUNT; i++){
+    out[i] = int(lround(weights[i]));
+  }
+  FILE * file = fopen(path, "w");
+  if(file == NULL){
+    fprintf(stderr, "cannot write %s\n", path);
+    exit(1);
+  }
+  const char * names[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+  fprintf(file, "#include \"eval_weights.h\"\n\n");
+  fprintf(file, "//Evaluation weights in centipawns. tools/texel_tuner.cpp writes this file, hand edits are fine between runs\n");
+  fprintf(file, "const EvalWeights EVAL_WEIGHTS = {\n  //pieceValue\n  {");
+  for(int t = 0; t < 6; t++){
+    fprintf(file, "%d%s", rounded.pieceValue[t], t < 5 ? ", " : "},\n");
+  }
+  fprintf(file, "  //placement\n  {\n");
+  for(int t = 0; t < 6; t++){
+    fprintf(file, "    //%s\n", names[t]);
+    for(int x = 0; x < 8; x++){
+      fprintf(file, "    %s", x == 0 ? "{{" : " {");
+      for(int y = 0; y < 8; y++){
+        fprintf(file, "%3d%s", rounded.placement[t][x][y], y < 7 ? "," : "");
+      }
+      fprintf(file, "}%s\n", x < 7 ? "," : (t < 5 ? "}," : "}"));
+    }
+  }
+  fprintf(file, "  },\n  //passedBonus\n  {");
+  for(int r = 0; r < 8; r++){
+    fprintf(file, "%d%s", rounded.passedBonus[r], r < 7 ? ", " : "},\n");
+  }
+  fprintf(file, "  //isolatedPenalty, doubledPenalty, backwardPenalty\n  %d, %d, %d,\n",
+          rounded.isolatedPenalty, rounded.doubledPenalty, rounded.backwardPenalty);
+  fprintf(file, "  //shieldNearBonus, shieldFarBonus, shieldMissingPenalty\n  %d, %d, %d\n};\n",
+          rounded.shieldNearBonus, rounded.shieldFarBonus, rounded.shieldMissingPenalty);
+  fclose(file);
+}
+
+int main(int argc, char * argv[]){
+  if(argc < 2){
+    fprintf(stderr, "usage: %s <dataset> [-epochs N] [-rate R] [-threads T] [-k K] [-out eval_weights.cpp]\n", argv[0]);
+    return 1;
+  }
+  int epochs = 1000;
+  double rate = 1.0;  //Adam step size in centipawns
+  int threadCount = max(1u, thread::hardware_concurrency());
+  double k = 0;       //0 fits K to the starting weights
+  const char * outPath = "eval_weights.cpp";
+  for(int a = 2; a + 1 < argc; a += 2){
+    if(strcmp(argv[a], "-epochs") == 0) epochs = atoi(argv[a+1]);
+    else if(strcmp(argv[a], "-rate") == 0) rate = atof(argv[a+1]);
+    else if(strcmp(argv[a], "-threads") == 0) threadCount = max(1, atoi(argv[a+1]));
+    else if(strcmp(argv[a], "-k") == 0) k = atof(argv[a+1]);
+    else if(strcmp(argv[a], "-out") == 0) outPath = argv[a+1];
+  }
+
+  Dataset data = load_dataset(argv[1], threadCount);
+  if(data.positions.empty()){
+    fprintf(stderr, "no labeled positions in %s\n", argv[1]);
+    return 1;
+  }
+  printf("%zu positions, %zu features, %d threads\n", data.positions.size(), data.features.size(), threadCount);
+
+  vector<double> weights(WEIGHT_COUNT);
+  const int * start = reinterpret_cast<const int *>(&EVAL_WEIGHTS);
+  for(int i = 0; i < WEIGHT_COUNT; i++){
+    weights[i] = start[i];
+  }
+  //The king's material value cancels out of every position, so it is never moved
+  vector<bool> frozen(WEIGHT_COUNT, false);
+  frozen[offsetof(EvalWeights, pieceValue) / sizeof(int) + KING_TYPE] = true;
+
+  if(k <= 0){
+    k = fit_k(data, weights.data(), threadCount);
+  }
+  printf("K %.4f, starting error %.6f\n", k, total_error(data, weights.data(), k, threadCount));
+
+  //Adam: steps follow a running average of the gradient, scaled by a running average of its size
+  const double beta1 = 0.9;
+  const double beta2 = 0.999;
+  const double epsilon = 1e-8;
+  vector<double> gradient(WEIGHT_COUNT), moment(WEIGHT_COUNT, 0.0), velocity(WEIGHT_COUNT, 0.0);
+  for(int epoch = 1; epoch <= epochs; epoch++){
+    compute_gradient(data, weights.data(), k, threadCount, gradient.data());
+    double correction1 = 1.0 - pow(beta1, epoch);
+    double correction2 = 1.0 - pow(beta2, epoch);
+    for(int i = 0; i < WEIGHT_COUNT; i++){
+      if(frozen[i]) continue;
+      moment[i] = beta1 * moment[i] + (1.0 - beta1) * gradient[i];
+      velocity[i] = beta2 * velocity[i] + (1.0 - beta2) * gradient[i] * gradient[i];
+      weights[i] -= rate * (moment[i] / correction1) / (sqrt(velocity[i] / correction2) + epsilon);
+    }
+    if(epoch % 50 == 0 || epoch == epochs){
+      printf("epoch %d error %.6f\n", epoch, total_error(data, weights.data(), k, threadCount));
+      write_weights(outPath, weights.data());
+    }
+  }
+  printf("weights written to %s\n", outPath);
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include "training_data.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+void encode_record(gameState & state, int whiteScore, Move bestMove, int result, TrainingRecord & record){
+  pack_position(state, record.position);
+  record.score = int16_t(max(-32000, min(32000, whiteScore)));
+  record.bestMove = bestMove;
+  record.result = int8_t(result);
+  record.unused[0] = record.unused[1] = record.unused[2] = 0;
+}
+
+void decode_record(const TrainingRecord & record, gameState & state){
+  unpack_position(record.position, state);
+}
+
+TrainingWriter::TrainingWriter(const string & path) : records(0), lost(0), offset(0){
+  fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+TrainingWriter::~TrainingWriter(){
+  if(fd >= 0){
+    close(fd);
+  }
+}
+
+bool TrainingWriter::write(const TrainingRecord * batch, int count){
+  size_t bytes = size_t(count) * sizeof(TrainingRecord);
+  uint64_t start = offset.fetch_add(bytes);
+  const char * data = reinterpret_cast<const char *>(batch);
+  //pwrite may write less than asked, so keep going until the whole batch is out
+  size_t done = 0;
+  while(done < bytes){
+    ssize_t written = pwrite(fd, data + done, bytes - done, start + done);
+    if(written <= 0) break;
+    done += written;
+  }
+  //Only whole records count as written
+  uint64_t whole = done / sizeof(TrainingRecord);
+  records += whole;
+  lost += count - whole;
+  return done == bytes;
+}
+
+RecordBuffer::RecordBuffer(TrainingWriter & writer) : writer(writer){
+  count = 0;
+}
+
+RecordBuffer::~RecordBuffer(){
+  flush();
+}
+
+void RecordBuffer::add(const TrainingRecord & record){
+  if(count == RECORD_BUFFER_SIZE){
+    flush();
+  }
+  records[count++] = record;
+}
+
+void RecordBuffer::flush(){
+  if(count > 0){
+    writer.write(records, count);
+    count = 0;
+  }
+}
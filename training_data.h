@@ -0,0 +1,82 @@
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+#include <atomic>
+#include <cstdint>
+#include "packed_position.h"
+
+//One labeled position, 40 bytes with no padding so a file of them is a plain array.
+//Multi-byte fields are stored in the machine's byte order, little endian on every machine this runs on
+struct TrainingRecord {
+  PackedPosition position;
+  int16_t score;          //Search score from white's side in centipawns, mate scores clamped to +-32000
+  Move bestMove;          //Move the search chose
+  int8_t result;          //Result of the game: 1 white won, 0 draw, -1 black won
+  uint8_t unused[3];
+};
+
+static_assert(sizeof(TrainingRecord) == 40, "TrainingRecord must be packed");
+
+const int RECORD_BUFFER_SIZE = 8192;  //Records a thread collects before writing them out
+
+//PRE : state must be populated correctly
+//POST: record holds the position, whiteScore, bestMove and result
+//DESC: Pack a position for writing to a training file
+void encode_record(gameState & state, int whiteScore, Move bestMove, int result, TrainingRecord & record);
+
+//PRE : record must have been made by encode_record
+//POST: state holds the record's position, with keys computed
+//DESC: Unpack a position read from a training file
+void decode_record(const TrainingRecord & record, gameState & state);
+
+//Training file shared by every thread. Each write reserves its place in the file with one atomic add and
+//then writes there with pwrite, so threads never wait on a lock or on each other's writes
+class TrainingWriter{
+  public:
+    atomic<uint64_t> records;  //Records written so far
+    atomic<uint64_t> lost;     //Records a failed write left out. Their place in the file is zeros, so it is unusable
+
+    //PRE : None
+    //POST: path is created or emptied, is_open says if it worked
+    //DESC: Open a training file for writing
+    TrainingWriter(const string & path);
+    ~TrainingWriter();
+
+    bool is_open() const { return fd >= 0; }
+
+    //PRE : the file must be open
+    //POST: the records are in the file, after or before any written by other threads at the same time.
+    //      returns FALSE if the write failed part way, the records not written are counted in lost
+    //DESC: Append records from any thread
+    bool write(const TrainingRecord * batch, int count);
+
+  private:
+    int fd;
+    atomic<uint64_t> offset;  //End of the space reserved so far
+
+    TrainingWriter(const TrainingWriter &);
+    TrainingWriter & operator=(const TrainingWriter &);
+};
+
+//One thread's buffer of records, written out to a TrainingWriter in large blocks
+class RecordBuffer{
+  public:
+    RecordBuffer(TrainingWriter & writer);
+    ~RecordBuffer();
+
+    //PRE : None
+    //POST: record is buffered, the buffer is written out first if it is full
+    //DESC: Add one record
+    void add(const TrainingRecord & record);
+
+    //PRE : None
+    //POST: every buffered record is written out
+    //DESC: Called when full and when the thread finishes
+    void flush();
+
+  private:
+    TrainingWriter & writer;
+    TrainingRecord records[RECORD_BUFFER_SIZE];
+    int count;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "transposition_table.h"
+#include "memory_accounting.h"
+
+TranspositionTable::TranspositionTable(int sizeMB){
+  uint64_t count = 1;
+  while(count * 2 * sizeof(TTBucket) <= uint64_t(sizeMB) * 1024 * 1024){
+    count *= 2;
+  }
+  memory.allocate(count * sizeof(TTBucket));
+  //Out of memory, fall back to a single bucket so the table still works
+  if(memory.data == NULL){
+    count = 1;
+    memory.allocate(sizeof(TTBucket));
+  }
+  memory_charge(MEMORY_TRANSPOSITION_TABLE, memory.bytes);
+  buckets = static_cast<TTBucket *>(memory.data);
+  mask = count - 1;
+  generation = 0;
+  probes = 0;
+  hits = 0;
+}
+
+TranspositionTable::~TranspositionTable(){
+  memory_charge(MEMORY_TRANSPOSITION_TABLE, -(long long)memory.bytes);
+}
+
+void TranspositionTable::clear(){
+  //A key of 0 marks an empty entry, the same as the evaluation cache
+  memory.clear();
+  generation = 0;
+  probes = 0;
+  hits = 0;
+}
+
+void TranspositionTable::new_search(){
+  generation = (generation + 4) & 0xFC;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry & entry){
+  probes++;
+  TTBucket & bucket = buckets[key & mask];
+  for(int i = 0; i < TT_BUCKET_SIZE; i++){
+    if(bucket.entries[i].key == key && key != 0){
+      hits++;
+      entry = bucket.entries[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, int bound){
+  TTBucket & bucket = buckets[key & mask];
+  TTEntry * replace = &bucket.entries[0];
+  for(int i = 0; i < TT_BUCKET_SIZE; i++){
+    TTEntry & entry = bucket.entries[i];
+    //The same position is always overwritten, keeping its old move if the new result has none
+    if(entry.key == key || entry.key == 0){
+      if(move == NO_MOVE && entry.key == key) move = entry.move;
+      replace = &entry;
+      break;
+    }
+    //Otherwise replace the entry worth least: from an older search first, then the shallowest
+    int age = uint8_t(generation - (entry.genBound & 0xFC)) / 4;
+    int replaceAge = uint8_t(generation - (replace->genBound & 0xFC)) / 4;
+    if(entry.depth - 8 * age < replace->depth - 8 * replaceAge){
+      replace = &entry;
+    }
+  }
+  replace->key = key;
+  replace->score = score;
+  replace->move = move;
+  replace->depth = int8_t(depth);
+  replace->genBound = uint8_t(generation | bound);
+}
+
+int TranspositionTable::hashfull(){
+  int used = 0;
+  int sampled = 0;
+  for(uint64_t b = 0; b <= mask && sampled < 1000; b++){
+    for(int i = 0; i < TT_BUCKET_SIZE && sampled < 1000; i++, sampled++){
+      TTEntry & entry = buckets[b].entries[i];
+      if(entry.key != 0 && (entry.genBound & 0xFC) == generation){
+        used++;
+      }
+    }
+  }
+  return sampled == 0 ? 0 : used * 1000 / sampled;
+}
@@ -0,0 +1,81 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+#include <cstdint>
+#include "move.h"
+#include "hash_memory.h"
+
+const int TT_BUCKET_SIZE = 4;  //Entries per bucket, one bucket fills one 64 byte cache line
+
+enum { BOUND_NONE = 0, BOUND_UPPER = 1, BOUND_LOWER = 2, BOUND_EXACT = 3 };
+
+//One stored search result, 16 bytes
+struct TTEntry {
+  uint64_t key;       //gameState::key of the searched position, 0 if the entry is empty
+  int32_t score;      //Score of the position for the color to move, mate scores counted from the position
+  Move move;          //Best move found, or NO_MOVE
+  int8_t depth;       //Depth left when the position was searched
+  uint8_t genBound;   //Generation of the search that stored it in the high 6 bits, BOUND_* in the low 2
+
+  int bound() const { return genBound & 3; }
+};
+
+struct alignas(64) TTBucket {
+  TTEntry entries[TT_BUCKET_SIZE];
+};
+
+//Hash table of search results indexed by gameState::key, shared by every iteration of a search and kept
+//between moves. Lookups are almost always cache misses, so the search prefetches a position's bucket
+//as soon as it makes the move leading to it, and the table lives in huge pages to save TLB misses.
+class TranspositionTable{
+  public:
+    long probes;  //Number of lookups since the last clear
+    long hits;    //Number of lookups that found the position
+
+    //PRE : sizeMB must be at least 1
+    //POST: table is allocated with the largest power of two number of buckets that fits in sizeMB
+    //DESC: Create an empty transposition table
+    TranspositionTable(int sizeMB = 64);
+    ~TranspositionTable();
+
+    //PRE : None
+    //POST: every entry is empty, counters are reset
+    //DESC: Forget every stored result
+    void clear();
+
+    //PRE : None
+    //POST: later stores are marked as newer than everything already in the table
+    //DESC: Called at the start of each search so old results are replaced first
+    void new_search();
+
+    //PRE : None
+    //POST: the key's bucket is on its way into the cache
+    //DESC: Call right after making a move, so the load overlaps the work before the probe
+    void prefetch(uint64_t key){
+      __builtin_prefetch(&buckets[key & mask]);
+    }
+
+    //PRE : None
+    //POST: returns TRUE and copies the entry if key is stored, returns FALSE if not
+    //DESC: Look up the result of an earlier search of a position
+    bool probe(uint64_t key, TTEntry & entry);
+
+    //PRE : score must already be counted from the position, see score_to_tt in search.cpp
+    //POST: the result is stored, replacing the oldest and shallowest entry of the bucket if needed
+    //DESC: Remember the result of searching a position
+    void store(uint64_t key, Move move, int score, int depth, int bound);
+
+    //PRE : None
+    //POST: returns how many of the first 1000 entries were stored by the current search
+    //DESC: Roughly how full the table is, in thousandths
+    int hashfull();
+
+    bool huge_pages() const { return memory.hugePages; }
+
+  private:
+    HashMemory memory;   //Holds the buckets
+    TTBucket * buckets;
+    uint64_t mask;       //Number of buckets - 1, used to turn a key into an index
+    uint8_t generation;  //Counts searches, kept in the high 6 bits of genBound
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+#include <cstdint>
+#include <string>
+
+//Random keys for hashing positions. A position's key is the XOR of the keys of everything in it,
+//so making a move only has to XOR out what changed and XOR in what replaced it.
+//The keys are generated by the compiler from a fixed seed so they are the same on every run.
+
+struct ZobristKeys {
+  uint64_t piece[12][64];   //one key per piece type per square, see piece_index
+  uint64_t castling[16];    //one key per combination of castling rights, see castling_mask
+  uint64_t en_passant[8];   //one key per file of the en passant square
+  uint64_t side;            //XORed in when black is to move
+};
+
+//PRE : None
+//POST: returns a well mixed 64 bit number for the seed
+//DESC: splitmix64 step, used to fill the key table
+constexpr uint64_t splitmix64(uint64_t seed){
+  seed += 0x9E3779B97F4A7C15ULL;
+  seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+  return seed ^ (seed >> 31);
+}
+
+constexpr ZobristKeys make_zobrist_keys(){
+  ZobristKeys keys = {};
+  uint64_t seed = 1070372;
+  for(int p = 0; p < 12; p++){
+    for(int s = 0; s < 64; s++){
+      keys.piece[p][s] = splitmix64(seed++);
+    }
+  }
+  for(int c = 0; c < 16; c++){
+    keys.castling[c] = splitmix64(seed++);
+  }
+  for(int f = 0; f < 8; f++){
+    keys.en_passant[f] = splitmix64(seed++);
+  }
+  keys.side = splitmix64(seed++);
+  return keys;
+}
+
+constexpr ZobristKeys ZOBRIST = make_zobrist_keys();
+
+//PRE : None
+//POST: returns 0-11 for "PNBRQKpnbrqk", -1 for a blank space
+//DESC: Index of a board character in the piece key table
+inline int piece_index(char piece){
+  switch(piece){
+    case 'P': return 0;
+    case 'N': return 1;
+    case 'B': return 2;
+    case 'R': return 3;
+    case 'Q': return 4;
+    case 'K': return 5;
+    case 'p': return 6;
+    case 'n': return 7;
+    case 'b': return 8;
+    case 'r': return 9;
+    case 'q': return 10;
+    case 'k': return 11;
+  }
+  return -1;
+}
+
+//PRE : castling must be the castling field of a fen string
+//POST: returns the rights as 4 bits, K = 1, Q = 2, k = 4, q = 8
+//DESC: Index of a set of castling rights in the castling key table
+inline int castling_mask(const std::string & castling){
+  int mask = 0;
+  for(char right : castling){
+    if(right == 'K') mask |= 1;
+    if(right == 'Q') mask |= 2;
+    if(right == 'k') mask |= 4;
+    if(right == 'q') mask |= 8;
+  }
+  return mask;
+}
+
+#endif